@@ -1,16 +1,20 @@
 #include "CaesarCipher.h"
-#include <iostream>
-#include <fstream>
 #include <cstring>
-
-CaesarCipher::CaesarCipher() : libraryHandle(nullptr), encryptFunc(nullptr), decryptFunc(nullptr) {
-    if (!loadLibrary()) {
-        std::cerr << "Failed to load Caesar cipher library" << std::endl;
-        return;
-    }
+#include <atomic>
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "../cpp/AtomicFileWriter.h"
+#include "../cpp/EditorError.h"
+#include "../cpp/ThreadPool.h"
+
+CaesarCipher::CaesarCipher()
+    : libraryHandle(nullptr), encryptFunc(nullptr), decryptFunc(nullptr), encryptIntoFunc(nullptr),
+      decryptIntoFunc(nullptr) {
+    if (!loadLibrary()) return;
 
     if (!loadFunctions()) {
-        std::cerr << "Failed to load Caesar cipher functions" << std::endl;
         unloadLibrary();
         return;
     }
@@ -27,7 +31,7 @@ bool CaesarCipher::loadLibrary() {
         // Try system library path
         libraryHandle = dlopen("libcaesar.dylib", RTLD_LAZY);
         if (!libraryHandle) {
-            std::cerr << "Failed to load libcaesar.dylib: " << dlerror() << std::endl;
+            loadErrorMessage = std::string("Failed to load libcaesar.dylib: ") + dlerror();
             return false;
         }
     }
@@ -40,6 +44,8 @@ void CaesarCipher::unloadLibrary() {
         libraryHandle = nullptr;
         encryptFunc = nullptr;
         decryptFunc = nullptr;
+        encryptIntoFunc = nullptr;
+        decryptIntoFunc = nullptr;
     }
 }
 
@@ -48,9 +54,11 @@ bool CaesarCipher::loadFunctions() {
 
     encryptFunc = (EncryptFunction)dlsym(libraryHandle, "caesar_encrypt");
     decryptFunc = (DecryptFunction)dlsym(libraryHandle, "caesar_decrypt");
+    encryptIntoFunc = (RangeFunction)dlsym(libraryHandle, "caesar_encrypt_into");
+    decryptIntoFunc = (RangeFunction)dlsym(libraryHandle, "caesar_decrypt_into");
 
-    if (!encryptFunc || !decryptFunc) {
-        std::cerr << "Failed to load Caesar cipher functions from library" << std::endl;
+    if (!encryptFunc || !decryptFunc || !encryptIntoFunc || !decryptIntoFunc) {
+        loadErrorMessage = "Failed to load Caesar cipher functions from library";
         return false;
     }
 
@@ -58,149 +66,237 @@ bool CaesarCipher::loadFunctions() {
 }
 
 bool CaesarCipher::isReady() const {
-    return (libraryHandle != nullptr && encryptFunc != nullptr && decryptFunc != nullptr);
+    return (libraryHandle != nullptr && encryptFunc != nullptr && decryptFunc != nullptr &&
+            encryptIntoFunc != nullptr && decryptIntoFunc != nullptr);
 }
 
-std::vector<char> CaesarCipher::encrypt(const std::vector<char>& data, int key) {
+bool CaesarCipher::encrypt(const char* input, char* output, size_t length, int key) {
     if (!isReady()) {
-        std::cerr << "Caesar cipher not ready" << std::endl;
-        return std::vector<char>();
+        setEditorError("Caesar cipher not ready");
+        return false;
     }
 
-    std::vector<char> result(data.size());
+    encryptIntoFunc(input, output, length, key);
+    return true;
+}
 
-    if (!data.empty()) {
-        encryptFunc(data.data(), result.data(), key, static_cast<int>(data.size()));
+bool CaesarCipher::decrypt(const char* input, char* output, size_t length, int key) {
+    if (!isReady()) {
+        setEditorError("Caesar cipher not ready");
+        return false;
     }
 
-    return result;
+    decryptIntoFunc(input, output, length, key);
+    return true;
 }
 
-std::vector<char> CaesarCipher::decrypt(const std::vector<char>& data, int key) {
+bool CaesarCipher::encryptInPlace(char* data, size_t length, int key) {
+    return encrypt(data, data, length, key);
+}
+
+bool CaesarCipher::decryptInPlace(char* data, size_t length, int key) {
+    return decrypt(data, data, length, key);
+}
+
+std::vector<char> CaesarCipher::encrypt(const std::vector<char>& data, int key) {
     if (!isReady()) {
-        std::cerr << "Caesar cipher not ready" << std::endl;
+        setEditorError("Caesar cipher not ready");
         return std::vector<char>();
     }
 
     std::vector<char> result(data.size());
+    encryptIntoFunc(data.data(), result.data(), data.size(), key);
+    return result;
+}
 
-    if (!data.empty()) {
-        decryptFunc(data.data(), result.data(), key, static_cast<int>(data.size()));
+std::vector<char> CaesarCipher::decrypt(const std::vector<char>& data, int key) {
+    if (!isReady()) {
+        setEditorError("Caesar cipher not ready");
+        return std::vector<char>();
     }
 
+    std::vector<char> result(data.size());
+    decryptIntoFunc(data.data(), result.data(), data.size(), key);
     return result;
 }
 
 std::string CaesarCipher::encrypt(const std::string& text, int key) {
     if (!isReady()) {
-        std::cerr << "Caesar cipher not ready" << std::endl;
+        setEditorError("Caesar cipher not ready");
         return "";
     }
 
-    std::vector<char> input(text.begin(), text.end());
-    std::vector<char> encrypted = encrypt(input, key);
-
-    return std::string(encrypted.begin(), encrypted.end());
+    std::string result(text);
+    encryptInPlace(&result[0], result.size(), key);
+    return result;
 }
 
 std::string CaesarCipher::decrypt(const std::string& text, int key) {
     if (!isReady()) {
-        std::cerr << "Caesar cipher not ready" << std::endl;
+        setEditorError("Caesar cipher not ready");
         return "";
     }
 
-    std::vector<char> input(text.begin(), text.end());
-    std::vector<char> decrypted = decrypt(input, key);
-
-    return std::string(decrypted.begin(), decrypted.end());
+    std::string result(text);
+    decryptInPlace(&result[0], result.size(), key);
+    return result;
 }
 
-bool CaesarCipher::encryptFile(const std::string& inputPath, const std::string& outputPath, int key) {
+// Stream inputPath through the cipher into outputPath one chunk at a time,
+// reusing a single buffer, so memory stays flat whatever the file size.
+// The output goes through AtomicFileWriter, which also makes it safe for
+// outputPath to be inputPath.
+bool CaesarCipher::transformFile(const std::string& inputPath, const std::string& outputPath, int key,
+                                 bool encrypting) {
     if (!isReady()) {
-        std::cerr << "Caesar cipher not ready" << std::endl;
+        setEditorError("Caesar cipher not ready");
         return false;
     }
 
-    // Read input file
-    std::ifstream inputFile(inputPath, std::ios::binary);
-    if (!inputFile.is_open()) {
-        std::cerr << "Failed to open input file: " << inputPath << std::endl;
+    int input = ::open(inputPath.c_str(), O_RDONLY);
+    if (input < 0) {
+        setEditorError(std::string("Failed to open ") + (encrypting ? "input" : "encrypted") + " file: " + inputPath);
         return false;
     }
-
-    // Read file content into vector
-    std::vector<char> fileData((std::istreambuf_iterator<char>(inputFile)),
-                               std::istreambuf_iterator<char>());
-    inputFile.close();
-
-    if (fileData.empty()) {
-        std::cerr << "Input file is empty or could not be read" << std::endl;
+#ifdef POSIX_FADV_SEQUENTIAL
+    posix_fadvise(input, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+
+    AtomicFileWriter writer(outputPath);
+    if (!writer.open()) {
+        setEditorError(std::string("Failed to open output file: ") + outputPath);
+        ::close(input);
         return false;
     }
 
-    // Encrypt the data
-    std::vector<char> encryptedData = encrypt(fileData, key);
+    std::vector<char> chunk(FILE_CHUNK_SIZE);
+    RangeFunction transform = encrypting ? encryptIntoFunc : decryptIntoFunc;
+    size_t total = 0;
+    bool failed = false;
+    for (;;) {
+        ssize_t count = read(input, chunk.data(), chunk.size());
+        if (count < 0) {
+            if (errno == EINTR) continue;
+            failed = true;
+            break;
+        }
+        if (count == 0) break;
 
-    if (encryptedData.empty()) {
-        std::cerr << "Encryption failed" << std::endl;
-        return false;
+        transform(chunk.data(), chunk.data(), (size_t)count, key);
+        if (!writer.write(chunk.data(), (size_t)count)) {
+            setEditorError(std::string("Failed to write output file: ") + outputPath);
+            ::close(input);
+            return false;
+        }
+        total += (size_t)count;
     }
+    ::close(input);
 
-    // Write encrypted data to output file
-    std::ofstream outputFile(outputPath, std::ios::binary);
-    if (!outputFile.is_open()) {
-        std::cerr << "Failed to open output file: " << outputPath << std::endl;
+    if (failed || total == 0) {
+        setEditorError(std::string(encrypting ? "Input" : "Encrypted") + " file is empty or could not be read");
+        return false;
+    }
+    if (!writer.commit()) {
+        setEditorError(std::string("Failed to write output file: ") + outputPath);
         return false;
     }
-
-    outputFile.write(encryptedData.data(), encryptedData.size());
-    outputFile.close();
-
-    std::cout << "File encrypted successfully: " << inputPath << " -> " << outputPath << std::endl;
     return true;
 }
 
-bool CaesarCipher::decryptFile(const std::string& inputPath, const std::string& outputPath, int key) {
+// Split the file into ranges handed to a thread pool. Every task reads its
+// range in FILE_CHUNK_SIZE pieces with pread, transforms them in place and
+// pwrites them to the same offsets of the output, so the workers share
+// nothing but the two file descriptors.
+bool CaesarCipher::transformFileParallel(const std::string& inputPath, const std::string& outputPath, int key,
+                                         bool encrypting, size_t threadCount) {
     if (!isReady()) {
-        std::cerr << "Caesar cipher not ready" << std::endl;
+        setEditorError("Caesar cipher not ready");
         return false;
     }
 
-    // Read encrypted file
-    std::ifstream inputFile(inputPath, std::ios::binary);
-    if (!inputFile.is_open()) {
-        std::cerr << "Failed to open encrypted file: " << inputPath << std::endl;
+    int input = ::open(inputPath.c_str(), O_RDONLY);
+    if (input < 0) {
+        setEditorError(std::string("Failed to open ") + (encrypting ? "input" : "encrypted") + " file: " + inputPath);
         return false;
     }
 
-    // Read file content into vector
-    std::vector<char> encryptedData((std::istreambuf_iterator<char>(inputFile)),
-                                    std::istreambuf_iterator<char>());
-    inputFile.close();
+    struct stat info;
+    if (fstat(input, &info) != 0 || !S_ISREG(info.st_mode)) {
+        ::close(input);
+        return transformFile(inputPath, outputPath, key, encrypting);
+    }
 
-    if (encryptedData.empty()) {
-        std::cerr << "Encrypted file is empty or could not be read" << std::endl;
+    size_t length = (size_t)info.st_size;
+    if (length == 0) {
+        setEditorError(std::string(encrypting ? "Input" : "Encrypted") + " file is empty or could not be read");
+        ::close(input);
         return false;
     }
 
-    // Decrypt the data
-    std::vector<char> decryptedData = decrypt(encryptedData, key);
-
-    if (decryptedData.empty()) {
-        std::cerr << "Decryption failed" << std::endl;
+    AtomicFileWriter writer(outputPath);
+    if (!writer.open()) {
+        setEditorError(std::string("Failed to open output file: ") + outputPath);
+        ::close(input);
         return false;
     }
 
-    // Write decrypted data to output file
-    std::ofstream outputFile(outputPath, std::ios::binary);
-    if (!outputFile.is_open()) {
-        std::cerr << "Failed to open output file: " << outputPath << std::endl;
+    ThreadPool pool(threadCount);
+    size_t rangeCount = pool.size() * 4;
+    size_t rangeSize = (length + rangeCount - 1) / rangeCount;
+    if (rangeSize < MIN_RANGE_SIZE) {
+        rangeSize = MIN_RANGE_SIZE;
+    }
+    rangeSize = (rangeSize + FILE_CHUNK_SIZE - 1) / FILE_CHUNK_SIZE * FILE_CHUNK_SIZE;
+
+    RangeFunction transform = encrypting ? encryptIntoFunc : decryptIntoFunc;
+    std::atomic<bool> failed(false);
+    for (size_t start = 0; start < length; start += rangeSize) {
+        size_t end = length - start > rangeSize ? start + rangeSize : length;
+        pool.submit([&, start, end]() {
+            std::vector<char> chunk(end - start < FILE_CHUNK_SIZE ? end - start : FILE_CHUNK_SIZE);
+            size_t offset = start;
+            while (offset < end && !failed.load(std::memory_order_relaxed)) {
+                size_t wanted = end - offset < chunk.size() ? end - offset : chunk.size();
+                ssize_t count = pread(input, chunk.data(), wanted, (off_t)offset);
+                if (count < 0 && errno == EINTR) continue;
+                if (count <= 0) {
+                    failed = true;   // an error, or the file shrank under us
+                    return;
+                }
+
+                transform(chunk.data(), chunk.data(), (size_t)count, key);
+                if (!writer.writeAt(chunk.data(), (size_t)count, offset)) {
+                    failed = true;
+                    return;
+                }
+                offset += (size_t)count;
+            }
+        });
+    }
+    pool.wait();
+    ::close(input);
+
+    if (failed || !writer.commit()) {
+        setEditorError(std::string("Failed to write output file: ") + outputPath);
         return false;
     }
+    return true;
+}
 
-    outputFile.write(decryptedData.data(), decryptedData.size());
-    outputFile.close();
+bool CaesarCipher::encryptFileParallel(const std::string& inputPath, const std::string& outputPath, int key,
+                                       size_t threadCount) {
+    return transformFileParallel(inputPath, outputPath, key, true, threadCount);
+}
 
-    std::cout << "File decrypted successfully: " << inputPath << " -> " << outputPath << std::endl;
-    return true;
-}
\ No newline at end of file
+bool CaesarCipher::decryptFileParallel(const std::string& inputPath, const std::string& outputPath, int key,
+                                       size_t threadCount) {
+    return transformFileParallel(inputPath, outputPath, key, false, threadCount);
+}
+
+bool CaesarCipher::encryptFile(const std::string& inputPath, const std::string& outputPath, int key) {
+    return transformFile(inputPath, outputPath, key, true);
+}
+
+bool CaesarCipher::decryptFile(const std::string& inputPath, const std::string& outputPath, int key) {
+    return transformFile(inputPath, outputPath, key, false);
+}
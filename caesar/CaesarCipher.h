@@ -3,7 +3,7 @@
 
 #include <vector>
 #include <string>
-#include "../main.h"
+#include "../cpp/TextEditorApi.h"
 
 // For Mac OS dynamic library loading
 #include <dlfcn.h>
@@ -12,23 +12,43 @@ typedef void* LibraryHandle;
 class CaesarCipher {
 private:
     LibraryHandle libraryHandle;
+    std::string loadErrorMessage;
 
     // Function pointers for library functions
     typedef void (*EncryptFunction)(const char* input, char* output, int key, int length);
     typedef void (*DecryptFunction)(const char* input, char* output, int key, int length);
+    typedef void (*RangeFunction)(const char* input, char* output, size_t length, int key);
 
     EncryptFunction encryptFunc;
     DecryptFunction decryptFunc;
+    RangeFunction encryptIntoFunc;
+    RangeFunction decryptIntoFunc;
 
     // Helper methods
     bool loadLibrary();
     void unloadLibrary();
     bool loadFunctions();
+    bool transformFile(const std::string& inputPath, const std::string& outputPath, int key, bool encrypting);
+    bool transformFileParallel(const std::string& inputPath, const std::string& outputPath, int key,
+                               bool encrypting, size_t threadCount);
 
 public:
+    // Files are streamed through a buffer of this size
+    static const size_t FILE_CHUNK_SIZE = 1 << 20;
+
+    // Parallel file transforms hand out ranges of at least this size
+    static const size_t MIN_RANGE_SIZE = (size_t)8 << 20;
+
     CaesarCipher();
     ~CaesarCipher();
 
+    // Caller-provided output of at least length bytes; output may equal
+    // input. No allocation, any length.
+    bool encrypt(const char* input, char* output, size_t length, int key);
+    bool decrypt(const char* input, char* output, size_t length, int key);
+    bool encryptInPlace(char* data, size_t length, int key);
+    bool decryptInPlace(char* data, size_t length, int key);
+
     // Main encryption/decryption methods
     std::vector<char> encrypt(const std::vector<char>& data, int key);
     std::vector<char> decrypt(const std::vector<char>& data, int key);
@@ -41,8 +61,18 @@ public:
     bool encryptFile(const std::string& inputPath, const std::string& outputPath, int key);
     bool decryptFile(const std::string& inputPath, const std::string& outputPath, int key);
 
-    // Status check
+    // The same on threadCount threads (0 = one per core), each reading its
+    // ranges with pread and writing them at the same offsets with pwrite.
+    // Input that is not a regular file is streamed as above.
+    bool encryptFileParallel(const std::string& inputPath, const std::string& outputPath, int key,
+                             size_t threadCount = 0);
+    bool decryptFileParallel(const std::string& inputPath, const std::string& outputPath, int key,
+                             size_t threadCount = 0);
+
+    // Status check, and why the library could not be loaded if it is not
+    // ready. Other failures are left for editorLastError.
     bool isReady() const;
+    const std::string& loadError() const { return loadErrorMessage; }
 };
 
 #endif // CAESAR_CIPHER_H
\ No newline at end of file
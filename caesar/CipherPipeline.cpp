@@ -0,0 +1,233 @@
+#include "CipherPipeline.h"
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <fstream>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+#include "CaesarCipher.h"
+#include "../cpp/ThreadPool.h"
+
+CipherPipeline::FileState::FileState(CipherPipeline* owner, const Job* job)
+    : owner(owner), job(job), outputFd(-1), bytes(0), failed(false) {
+}
+
+CipherPipeline::FileState::~FileState() {
+    if (outputFd >= 0) {
+        if (close(outputFd) != 0) failed = true;
+        if (!failed && rename(tempPath.c_str(), job->output.c_str()) != 0) failed = true;
+        if (failed) unlink(tempPath.c_str());
+    }
+
+    if (failed) {
+        owner->report("Failed to encrypt " + job->input + " -> " + job->output);
+        owner->failedFiles++;
+    } else {
+        owner->doneFiles++;
+        owner->doneBytes += bytes;
+    }
+}
+
+CipherPipeline::CipherPipeline(CaesarCipher& cipher, size_t ioThreads)
+    : cipher(cipher), ioThreads(ioThreads ? ioThreads : 4), transformThreads(ThreadPool::hardwareThreads()),
+      outputMode(0666), jobs(nullptr), nextJob(0), doneFiles(0), failedFiles(0), doneBytes(0),
+      readQueue(QUEUE_CHUNKS), writeQueue(QUEUE_CHUNKS) {
+}
+
+void CipherPipeline::report(const std::string& message) {
+    std::lock_guard<std::mutex> lock(problemsMutex);
+    problemText += message;
+    problemText += '\n';
+}
+
+std::string CipherPipeline::problems() {
+    std::lock_guard<std::mutex> lock(problemsMutex);
+    return problemText;
+}
+
+bool CipherPipeline::readManifest(const std::string& path, std::vector<Job>& jobs, size_t& invalid,
+                                  std::string& problems) {
+    std::ifstream manifest(path);
+    if (!manifest.is_open()) return false;
+
+    std::string line;
+    size_t lineNumber = 0;
+    invalid = 0;
+    while (std::getline(manifest, line)) {
+        lineNumber++;
+        if (!line.empty() && line[line.size() - 1] == '\r') line.erase(line.size() - 1);
+        if (line.find_first_not_of(" \t") == std::string::npos || line[0] == '#') continue;
+
+        // Tabs separate the fields when there are any, otherwise spaces do
+        const char* separators = line.find('\t') != std::string::npos ? "\t" : " ";
+        std::vector<std::string> fields;
+        size_t start = 0;
+        while (start <= line.size()) {
+            size_t end = line.find_first_of(separators, start);
+            if (end == std::string::npos) end = line.size();
+            if (end > start) fields.push_back(line.substr(start, end - start));
+            start = end + 1;
+        }
+
+        char* keyEnd = nullptr;
+        long key = fields.size() == 3 ? strtol(fields[2].c_str(), &keyEnd, 10) : 0;
+        if (fields.size() != 3 || *keyEnd != '\0') {
+            problems += path + ":" + std::to_string(lineNumber) + ": expected input, output and key\n";
+            invalid++;
+            continue;
+        }
+
+        Job job;
+        job.input = fields[0];
+        job.output = fields[1];
+        job.key = (int)(key % 26);
+        jobs.push_back(job);
+    }
+    return true;
+}
+
+void CipherPipeline::readFile(const Job& job) {
+    std::shared_ptr<FileState> file = std::make_shared<FileState>(this, &job);
+
+    int input = open(job.input.c_str(), O_RDONLY);
+    if (input < 0) {
+        file->failed = true;
+        return;
+    }
+
+    // Refuse to read and write one file, also through a link; the output
+    // only replaces the input once it is complete, so the check is all
+    // that stands between the two
+    struct stat info;
+    struct stat existing;
+    bool replacing = stat(job.output.c_str(), &existing) == 0;
+    if (fstat(input, &info) != 0 ||
+        (replacing && existing.st_dev == info.st_dev && existing.st_ino == info.st_ino)) {
+        if (replacing) report(job.output + ": output is the input file");
+        file->failed = true;
+        close(input);
+        return;
+    }
+
+    // Write next to the output and rename over it once the last chunk is
+    // in, so a failed job leaves an existing output untouched
+    std::vector<char> pattern(job.output.begin(), job.output.end());
+    const char suffix[] = ".tmp.XXXXXX";
+    pattern.insert(pattern.end(), suffix, suffix + sizeof(suffix));
+    file->outputFd = mkstemp(pattern.data());
+    if (file->outputFd < 0) {
+        file->failed = true;
+        close(input);
+        return;
+    }
+    file->tempPath = pattern.data();
+    fchmod(file->outputFd, replacing ? existing.st_mode & 07777 : outputMode);
+
+    // Small files, the common case, are read in one go
+    size_t chunkSize = CHUNK_SIZE;
+    if (S_ISREG(info.st_mode) && (size_t)info.st_size < CHUNK_SIZE) {
+        chunkSize = (size_t)info.st_size + 1;   // + 1 to see end of file in the same read
+    }
+
+    size_t offset = 0;
+    for (;;) {
+        Chunk chunk;
+        chunk.data.resize(chunkSize);
+        ssize_t count = read(input, chunk.data.data(), chunk.data.size());
+        if (count < 0) {
+            if (errno == EINTR) continue;
+            file->failed = true;
+            break;
+        }
+        if (count == 0) break;
+
+        chunk.data.resize((size_t)count);
+        chunk.file = file;
+        chunk.offset = offset;
+        offset += (size_t)count;
+        file->bytes += (size_t)count;
+        if (!readQueue.push(std::move(chunk))) break;
+    }
+    close(input);
+}
+
+void CipherPipeline::readLoop() {
+    for (;;) {
+        size_t index = nextJob++;
+        if (index >= jobs->size()) return;
+        readFile((*jobs)[index]);
+    }
+}
+
+void CipherPipeline::transformLoop() {
+    Chunk chunk;
+    while (readQueue.pop(chunk)) {
+        if (!chunk.file->failed) {
+            cipher.encryptInPlace(chunk.data.data(), chunk.data.size(), chunk.file->job->key);
+            writeQueue.push(std::move(chunk));
+        }
+        chunk = Chunk();
+    }
+}
+
+void CipherPipeline::writeLoop() {
+    Chunk chunk;
+    while (writeQueue.pop(chunk)) {
+        const char* data = chunk.data.data();
+        size_t length = chunk.data.size();
+        size_t offset = chunk.offset;
+        while (length > 0 && !chunk.file->failed) {
+            ssize_t count = pwrite(chunk.file->outputFd, data, length, (off_t)offset);
+            if (count < 0) {
+                if (errno != EINTR) chunk.file->failed = true;
+                continue;
+            }
+            data += count;
+            length -= (size_t)count;
+            offset += (size_t)count;
+        }
+        chunk = Chunk();   // drop the file reference now, not at the next pop
+    }
+}
+
+void CipherPipeline::run(const std::vector<Job>& jobList, EncryptBatchStats& stats) {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    jobs = &jobList;
+    problemText.clear();
+    nextJob = 0;
+    doneFiles = 0;
+    failedFiles = 0;
+    doneBytes = 0;
+
+    // mkstemp creates 0600; new outputs get the usual default. umask can
+    // only be read by setting it, so do that before any thread starts.
+    mode_t mask = umask(0);
+    umask(mask);
+    outputMode = 0666 & ~mask;
+
+    std::vector<std::thread> readers, transformers, writers;
+    for (size_t i = 0; i < ioThreads; i++) {
+        readers.push_back(std::thread(&CipherPipeline::readLoop, this));
+        writers.push_back(std::thread(&CipherPipeline::writeLoop, this));
+    }
+    for (size_t i = 0; i < transformThreads; i++) {
+        transformers.push_back(std::thread(&CipherPipeline::transformLoop, this));
+    }
+
+    // Shut the stages down in order, each once its producers are done
+    for (size_t i = 0; i < readers.size(); i++) readers[i].join();
+    readQueue.close();
+    for (size_t i = 0; i < transformers.size(); i++) transformers[i].join();
+    writeQueue.close();
+    for (size_t i = 0; i < writers.size(); i++) writers[i].join();
+
+    stats.files = doneFiles;
+    stats.failed = failedFiles;
+    stats.bytes = doneBytes;
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    jobs = nullptr;
+}
@@ -0,0 +1,104 @@
+#ifndef CIPHER_PIPELINE_H
+#define CIPHER_PIPELINE_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <sys/types.h>
+#include <vector>
+#include "../cpp/BoundedQueue.h"
+#include "../cpp/TextEditorApi.h"
+
+class CaesarCipher;
+
+// Encrypts many files at once as a three-stage pipeline: reader threads
+// open each input and its output and read it in chunks, transform threads
+// run the cipher over them, and writer threads pwrite them to the output.
+// Bounded queues between the stages keep memory flat and let one file's
+// open/read latency overlap with another's transform and write.
+//
+// The manifest has one job per line, "input<TAB>output<TAB>key" (or the
+// three separated by spaces when no path contains one); a negative key
+// decrypts. Blank lines and lines starting with '#' are skipped.
+//
+// Each output is written to a temporary file beside it and renamed over it
+// when complete, like AtomicFileWriter but without the fsyncs: a batch of
+// many small files cannot afford one each. A failed job leaves the output
+// as it was, and a job whose output is its own input fails. A pipeline
+// runs one batch.
+class CipherPipeline {
+public:
+    struct Job {
+        std::string input;
+        std::string output;
+        int key;
+    };
+
+private:
+    // One job in flight. Every chunk of the file holds a reference, so the
+    // last stage to finish with it commits the output and books the result.
+    struct FileState {
+        CipherPipeline* owner;
+        const Job* job;
+        std::string tempPath;
+        int outputFd;
+        size_t bytes;
+        std::atomic<bool> failed;
+
+        FileState(CipherPipeline* owner, const Job* job);
+        ~FileState();
+    };
+
+    struct Chunk {
+        std::shared_ptr<FileState> file;
+        size_t offset;
+        std::vector<char> data;
+    };
+
+    CaesarCipher& cipher;
+    size_t ioThreads;
+    size_t transformThreads;
+    mode_t outputMode;
+
+    const std::vector<Job>* jobs;
+    std::atomic<size_t> nextJob;
+    std::atomic<size_t> doneFiles;
+    std::atomic<size_t> failedFiles;
+    std::atomic<size_t> doneBytes;
+    std::mutex problemsMutex;
+    std::string problemText;
+    BoundedQueue<Chunk> readQueue;
+    BoundedQueue<Chunk> writeQueue;
+
+    void readLoop();
+    void transformLoop();
+    void writeLoop();
+    void readFile(const Job& job);
+    void report(const std::string& message);
+
+public:
+    static const size_t CHUNK_SIZE = 1 << 20;
+    static const size_t QUEUE_CHUNKS = 64;
+
+    // ioThreads readers and as many writers; 0 means 4. The cipher runs on
+    // one thread per core.
+    CipherPipeline(CaesarCipher& cipher, size_t ioThreads = 0);
+
+    // Jobs from a manifest; bad lines are counted in invalid and described
+    // in problems, one per line
+    static bool readManifest(const std::string& path, std::vector<Job>& jobs, size_t& invalid,
+                             std::string& problems);
+
+    // Run every job; failed jobs leave their outputs untouched. problems
+    // then describes each failure, one per line.
+    void run(const std::vector<Job>& jobs, EncryptBatchStats& stats);
+    std::string problems();
+
+private:
+    CipherPipeline(const CipherPipeline&);
+    CipherPipeline& operator=(const CipherPipeline&);
+};
+
+#endif // CIPHER_PIPELINE_H
@@ -1,17 +1,21 @@
 #include "DataTypeHandler.h"
-#include <iostream>
+#include <ostream>
 #include <sstream>
 #include <cstring>
 #include <algorithm>
+#include "../cpp/EditorError.h"
+#include "../cpp/Regex.h"
+#include "../cpp/TrigramIndex.h"
 
-DataTypeHandler::DataTypeHandler(Document* doc) : document(doc) {
+DataTypeHandler::DataTypeHandler(Document* doc) : document(doc), searchIndex(nullptr), recording(true) {
     if (!document) {
-        std::cerr << "Error: Document pointer is null" << std::endl;
+        setEditorError("Document pointer is null");
     }
 }
 
 DataTypeHandler::~DataTypeHandler() {
     // Note: We don't delete the document here as it's owned by the caller
+    delete searchIndex;
 }
 
 void DataTypeHandler::ensureCapacity(size_t requiredCapacity) {
@@ -22,7 +26,7 @@ void DataTypeHandler::ensureCapacity(size_t requiredCapacity) {
             document->lines = newLines;
             document->capacity = newCapacity;
         } else {
-            std::cerr << "Error: Failed to allocate memory for lines" << std::endl;
+            setEditorError("Failed to allocate memory for lines");
         }
     }
 }
@@ -36,8 +40,10 @@ void DataTypeHandler::addTextLine(const std::string& text) {
     if (line.data.text) {
         strcpy(line.data.text, text.c_str());
         document->lineCount++;
+        indexAppendedLine();
+        recordLine(LINE_ADDED, document->lineCount - 1, nullptr);
     } else {
-        std::cerr << "Error: Failed to allocate memory for text line" << std::endl;
+        setEditorError("Failed to allocate memory for text line");
     }
 }
 
@@ -58,6 +64,8 @@ void DataTypeHandler::addContactLine(const std::string& name, const std::string&
     line.data.contact.email[sizeof(line.data.contact.email) - 1] = '\0';
 
     document->lineCount++;
+    indexAppendedLine();
+    recordLine(LINE_ADDED, document->lineCount - 1, nullptr);
 }
 
 void DataTypeHandler::addChecklistLine(const std::string& info, bool checked) {
@@ -71,6 +79,8 @@ void DataTypeHandler::addChecklistLine(const std::string& info, bool checked) {
     line.data.checklist.checked = checked ? 1 : 0;
 
     document->lineCount++;
+    indexAppendedLine();
+    recordLine(LINE_ADDED, document->lineCount - 1, nullptr);
 }
 
 bool DataTypeHandler::editTextLine(size_t lineIndex, const std::string& newText) {
@@ -78,13 +88,20 @@ bool DataTypeHandler::editTextLine(size_t lineIndex, const std::string& newText)
         return false;
     }
 
-    free(document->lines[lineIndex].data.text);
-    document->lines[lineIndex].data.text = (char*)malloc(newText.length() + 1);
-    if (document->lines[lineIndex].data.text) {
-        strcpy(document->lines[lineIndex].data.text, newText.c_str());
-        return true;
+    char* text = (char*)malloc(newText.length() + 1);
+    if (!text) {
+        return false;
     }
-    return false;
+
+    LineState before;
+    captureLine(lineIndex, before);
+
+    free(document->lines[lineIndex].data.text);
+    document->lines[lineIndex].data.text = text;
+    strcpy(text, newText.c_str());
+    indexUpdatedLine(lineIndex);
+    recordLine(LINE_EDITED, lineIndex, &before);
+    return true;
 }
 
 bool DataTypeHandler::editContactLine(size_t lineIndex, const std::string& name, const std::string& surname, const std::string& email) {
@@ -92,6 +109,9 @@ bool DataTypeHandler::editContactLine(size_t lineIndex, const std::string& name,
         return false;
     }
 
+    LineState before;
+    captureLine(lineIndex, before);
+
     strncpy(document->lines[lineIndex].data.contact.name, name.c_str(), sizeof(document->lines[lineIndex].data.contact.name) - 1);
     document->lines[lineIndex].data.contact.name[sizeof(document->lines[lineIndex].data.contact.name) - 1] = '\0';
 
@@ -101,6 +121,8 @@ bool DataTypeHandler::editContactLine(size_t lineIndex, const std::string& name,
     strncpy(document->lines[lineIndex].data.contact.email, email.c_str(), sizeof(document->lines[lineIndex].data.contact.email) - 1);
     document->lines[lineIndex].data.contact.email[sizeof(document->lines[lineIndex].data.contact.email) - 1] = '\0';
 
+    indexUpdatedLine(lineIndex);
+    recordLine(LINE_EDITED, lineIndex, &before);
     return true;
 }
 
@@ -109,10 +131,15 @@ bool DataTypeHandler::editChecklistLine(size_t lineIndex, const std::string& inf
         return false;
     }
 
+    LineState before;
+    captureLine(lineIndex, before);
+
     strncpy(document->lines[lineIndex].data.checklist.info, info.c_str(), sizeof(document->lines[lineIndex].data.checklist.info) - 1);
     document->lines[lineIndex].data.checklist.info[sizeof(document->lines[lineIndex].data.checklist.info) - 1] = '\0';
     document->lines[lineIndex].data.checklist.checked = checked ? 1 : 0;
 
+    indexUpdatedLine(lineIndex);
+    recordLine(LINE_EDITED, lineIndex, &before);
     return true;
 }
 
@@ -121,7 +148,11 @@ bool DataTypeHandler::toggleChecklistItem(size_t lineIndex) {
         return false;
     }
 
+    LineState before;
+    captureLine(lineIndex, before);
+
     document->lines[lineIndex].data.checklist.checked = !document->lines[lineIndex].data.checklist.checked;
+    recordLine(LINE_EDITED, lineIndex, &before);
     return true;
 }
 
@@ -130,6 +161,14 @@ bool DataTypeHandler::deleteLine(size_t lineIndex) {
         return false;
     }
 
+    LineState before;
+    captureLine(lineIndex, before);
+    removeLineAt(lineIndex);
+    recordLine(LINE_DELETED, lineIndex, &before);
+    return true;
+}
+
+void DataTypeHandler::removeLineAt(size_t lineIndex) {
     freeLine(lineIndex);
 
     // Move remaining lines down
@@ -138,9 +177,128 @@ bool DataTypeHandler::deleteLine(size_t lineIndex) {
     }
 
     document->lineCount--;
+    if (searchIndex) {
+        searchIndex->eraseLine(lineIndex);
+    }
+}
+
+bool DataTypeHandler::insertLineAt(size_t lineIndex, const LineState& state) {
+    ensureCapacity(document->lineCount + 1);
+    if (document->capacity < document->lineCount + 1) {
+        return false;
+    }
+
+    LineData* lines = document->lines;
+    memmove(lines + lineIndex + 1, lines + lineIndex, (document->lineCount - lineIndex) * sizeof(LineData));
+    if (!placeLine(lineIndex, state)) {
+        memmove(lines + lineIndex, lines + lineIndex + 1, (document->lineCount - lineIndex) * sizeof(LineData));
+        return false;
+    }
+
+    document->lineCount++;
+    if (searchIndex) {
+        searchIndex->insertLine(lineIndex, lineFields(lineIndex));
+    }
     return true;
 }
 
+void DataTypeHandler::captureLine(size_t lineIndex, LineState& state) const {
+    const LineData& line = document->lines[lineIndex];
+    state.line = line;
+    if (line.type == DATA_TYPE_TEXT) {
+        state.text = line.data.text ? line.data.text : "";
+        state.line.data.text = nullptr;
+    }
+}
+
+// Write a captured line into a slot whose previous contents were released
+bool DataTypeHandler::placeLine(size_t lineIndex, const LineState& state) {
+    LineData& line = document->lines[lineIndex];
+    line = state.line;
+    if (line.type == DATA_TYPE_TEXT) {
+        line.data.text = (char*)malloc(state.text.length() + 1);
+        if (!line.data.text) {
+            setEditorError("Failed to allocate memory for text line");
+            return false;
+        }
+        memcpy(line.data.text, state.text.c_str(), state.text.length() + 1);
+    }
+    return true;
+}
+
+void DataTypeHandler::recordLine(LineChange change, size_t lineIndex, LineState* before) {
+    if (!recording) return;
+
+    redoRecords.clear();
+    if (undoRecords.size() == HISTORY_LIMIT) {
+        undoRecords.pop_front();
+    }
+
+    undoRecords.push_back(LineRecord());
+    LineRecord& record = undoRecords.back();
+    record.change = change;
+    record.index = lineIndex;
+    if (before) {
+        record.before.line = before->line;
+        record.before.text.swap(before->text);
+    }
+    if (change != LINE_DELETED) {
+        captureLine(lineIndex, record.after);
+    }
+}
+
+bool DataTypeHandler::applyRecord(const LineRecord& record, bool forward) {
+    LineChange change = record.change;
+    if (!forward && change != LINE_EDITED) {
+        change = change == LINE_ADDED ? LINE_DELETED : LINE_ADDED;
+    }
+    const LineState& target = forward ? record.after : record.before;
+
+    switch (change) {
+        case LINE_EDITED:
+            if (!isValidLineIndex(record.index)) return false;
+            freeLine(record.index);
+            if (!placeLine(record.index, target)) return false;
+            indexUpdatedLine(record.index);
+            return true;
+        case LINE_ADDED:
+            if (record.index > document->lineCount) return false;
+            return insertLineAt(record.index, target);
+        case LINE_DELETED:
+            if (!isValidLineIndex(record.index)) return false;
+            removeLineAt(record.index);
+            return true;
+    }
+    return false;
+}
+
+bool DataTypeHandler::undo() {
+    if (undoRecords.empty() || !applyRecord(undoRecords.back(), false)) {
+        return false;
+    }
+
+    redoRecords.push_back(LineRecord());
+    std::swap(redoRecords.back(), undoRecords.back());
+    undoRecords.pop_back();
+    return true;
+}
+
+bool DataTypeHandler::redo() {
+    if (redoRecords.empty() || !applyRecord(redoRecords.back(), true)) {
+        return false;
+    }
+
+    undoRecords.push_back(LineRecord());
+    std::swap(undoRecords.back(), redoRecords.back());
+    redoRecords.pop_back();
+    return true;
+}
+
+void DataTypeHandler::clearHistory() {
+    undoRecords.clear();
+    redoRecords.clear();
+}
+
 void DataTypeHandler::freeLine(size_t lineIndex) {
     if (isValidLineIndex(lineIndex) && document->lines[lineIndex].type == DATA_TYPE_TEXT) {
         free(document->lines[lineIndex].data.text);
@@ -190,6 +348,16 @@ std::string DataTypeHandler::serializeLine(size_t lineIndex) {
 }
 
 bool DataTypeHandler::deserializeDocument(const std::vector<char>& data) {
+    // The loaded lines replace the document, so the old records no longer
+    // apply and the loaded ones are not recorded one by one
+    clearHistory();
+    recording = false;
+    bool loaded = parseDocument(data);
+    recording = true;
+    return loaded;
+}
+
+bool DataTypeHandler::parseDocument(const std::vector<char>& data) {
     std::string content(data.begin(), data.end());
     std::istringstream iss(content);
     std::string line;
@@ -199,6 +367,9 @@ bool DataTypeHandler::deserializeDocument(const std::vector<char>& data) {
         freeLine(i);
     }
     document->lineCount = 0;
+    if (searchIndex) {
+        searchIndex->clear();
+    }
 
     // Read header
     if (!std::getline(iss, line)) return false;
@@ -250,18 +421,18 @@ bool DataTypeHandler::deserializeLine(const std::string& data, size_t lineIndex)
     return false;
 }
 
-void DataTypeHandler::printDocument() {
-    std::cout << "\n=== Document Content ===" << std::endl;
+void DataTypeHandler::printDocument(std::ostream& out) {
+    out << "\n=== Document Content ===" << std::endl;
     for (size_t i = 0; i < document->lineCount; i++) {
-        std::cout << i << ": ";
-        printLine(i);
+        out << i << ": ";
+        printLine(out, i);
     }
-    std::cout << "=== End of Document ===" << std::endl;
+    out << "=== End of Document ===" << std::endl;
 }
 
-void DataTypeHandler::printLine(size_t lineIndex) {
+void DataTypeHandler::printLine(std::ostream& out, size_t lineIndex) {
     if (!isValidLineIndex(lineIndex)) {
-        std::cout << "[Invalid line]" << std::endl;
+        out << "[Invalid line]" << std::endl;
         return;
     }
 
@@ -269,14 +440,14 @@ void DataTypeHandler::printLine(size_t lineIndex) {
 
     switch (line.type) {
         case DATA_TYPE_TEXT:
-            std::cout << "[TEXT] " << (line.data.text ? line.data.text : "") << std::endl;
+            out << "[TEXT] " << (line.data.text ? line.data.text : "") << std::endl;
             break;
         case DATA_TYPE_CONTACT:
-            std::cout << "[CONTACT] " << line.data.contact.name << " "
+            out << "[CONTACT] " << line.data.contact.name << " "
                       << line.data.contact.surname << " <" << line.data.contact.email << ">" << std::endl;
             break;
         case DATA_TYPE_CHECKLIST:
-            std::cout << "[CHECKLIST] " << (line.data.checklist.checked ? "[✓]" : "[ ]")
+            out << "[CHECKLIST] " << (line.data.checklist.checked ? "[✓]" : "[ ]")
                       << " " << line.data.checklist.info << std::endl;
             break;
     }
@@ -285,25 +456,122 @@ void DataTypeHandler::printLine(size_t lineIndex) {
 std::vector<size_t> DataTypeHandler::searchInDocument(const std::string& searchText) {
     std::vector<size_t> results;
 
+    // With the index only the candidate lines need to be checked
+    std::vector<size_t> candidates;
+    if (searchIndex && searchIndex->candidates(searchText, candidates)) {
+        for (size_t i = 0; i < candidates.size(); i++) {
+            if (lineContains(candidates[i], searchText)) {
+                results.push_back(candidates[i]);
+            }
+        }
+        return results;
+    }
+
+    for (size_t i = 0; i < document->lineCount; i++) {
+        if (lineContains(i, searchText)) {
+            results.push_back(i);
+        }
+    }
+
+    return results;
+}
+
+bool DataTypeHandler::lineContains(size_t lineIndex, const std::string& searchText) const {
+    const LineData& line = document->lines[lineIndex];
+
+    switch (line.type) {
+        case DATA_TYPE_TEXT:
+            return line.data.text && strstr(line.data.text, searchText.c_str());
+        case DATA_TYPE_CONTACT:
+            return strstr(line.data.contact.name, searchText.c_str()) ||
+                   strstr(line.data.contact.surname, searchText.c_str()) ||
+                   strstr(line.data.contact.email, searchText.c_str());
+        case DATA_TYPE_CHECKLIST:
+            return strstr(line.data.checklist.info, searchText.c_str()) != nullptr;
+    }
+
+    return false;
+}
+
+std::vector<std::string> DataTypeHandler::lineFields(size_t lineIndex) const {
+    std::vector<std::string> fields;
+    const LineData& line = document->lines[lineIndex];
+
+    switch (line.type) {
+        case DATA_TYPE_TEXT:
+            fields.push_back(line.data.text ? line.data.text : "");
+            break;
+        case DATA_TYPE_CONTACT:
+            fields.push_back(line.data.contact.name);
+            fields.push_back(line.data.contact.surname);
+            fields.push_back(line.data.contact.email);
+            break;
+        case DATA_TYPE_CHECKLIST:
+            fields.push_back(line.data.checklist.info);
+            break;
+    }
+
+    return fields;
+}
+
+void DataTypeHandler::indexAppendedLine() {
+    if (searchIndex) {
+        searchIndex->appendLine(lineFields(document->lineCount - 1));
+    }
+}
+
+void DataTypeHandler::indexUpdatedLine(size_t lineIndex) {
+    if (searchIndex) {
+        searchIndex->updateLine(lineIndex, lineFields(lineIndex));
+    }
+}
+
+void DataTypeHandler::enableSearchIndex(bool enabled) {
+    if (!enabled) {
+        delete searchIndex;
+        searchIndex = nullptr;
+        return;
+    }
+    if (searchIndex) return;
+
+    searchIndex = new TrigramIndex();
+    for (size_t i = 0; i < document->lineCount; i++) {
+        searchIndex->appendLine(lineFields(i));
+    }
+}
+
+bool DataTypeHandler::isSearchIndexEnabled() const {
+    return searchIndex != nullptr;
+}
+
+std::vector<size_t> DataTypeHandler::searchInDocumentRegex(const std::string& pattern) {
+    std::vector<size_t> results;
+
+    Regex regex(pattern);
+    if (!regex.isValid()) {
+        setEditorError("Invalid regular expression: " + regex.error());
+        return results;
+    }
+
     for (size_t i = 0; i < document->lineCount; i++) {
         const LineData& line = document->lines[i];
         bool found = false;
 
         switch (line.type) {
             case DATA_TYPE_TEXT:
-                if (line.data.text && strstr(line.data.text, searchText.c_str())) {
+                if (line.data.text && regex.search(line.data.text, strlen(line.data.text))) {
                     found = true;
                 }
                 break;
             case DATA_TYPE_CONTACT:
-                if (strstr(line.data.contact.name, searchText.c_str()) ||
-                    strstr(line.data.contact.surname, searchText.c_str()) ||
-                    strstr(line.data.contact.email, searchText.c_str())) {
+                if (regex.search(line.data.contact.name, strlen(line.data.contact.name)) ||
+                    regex.search(line.data.contact.surname, strlen(line.data.contact.surname)) ||
+                    regex.search(line.data.contact.email, strlen(line.data.contact.email))) {
                     found = true;
                 }
                 break;
             case DATA_TYPE_CHECKLIST:
-                if (strstr(line.data.checklist.info, searchText.c_str())) {
+                if (regex.search(line.data.checklist.info, strlen(line.data.checklist.info))) {
                     found = true;
                 }
                 break;
@@ -1,13 +1,45 @@
 #ifndef DATA_TYPE_HANDLER_H
 #define DATA_TYPE_HANDLER_H
 
+#include <deque>
+#include <iosfwd>
 #include <string>
 #include <vector>
-#include "../main.h"
+#include "../cpp/TextEditorApi.h"
+
+class TrigramIndex;
 
 class DataTypeHandler {
 private:
+    // A copy of one line that owns its text
+    struct LineState {
+        LineData line;       // data.text is unused; text lines keep it in text
+        std::string text;
+    };
+
+    enum LineChange {
+        LINE_EDITED,
+        LINE_ADDED,
+        LINE_DELETED
+    };
+
+    // One undoable change: the touched index and the line before and after
+    // it, so undoing it touches that line only (plus the shift of the lines
+    // behind it when a line comes or goes)
+    struct LineRecord {
+        LineChange change;
+        size_t index;
+        LineState before;    // unused for LINE_ADDED
+        LineState after;     // unused for LINE_DELETED
+    };
+
+    static const size_t HISTORY_LIMIT = 1024;
+
     Document* document;
+    TrigramIndex* searchIndex;
+    std::deque<LineRecord> undoRecords;
+    std::vector<LineRecord> redoRecords;
+    bool recording;
 
 public:
     DataTypeHandler(Document* doc);
@@ -27,16 +59,29 @@ public:
     bool toggleChecklistItem(size_t lineIndex);
     bool deleteLine(size_t lineIndex);
 
+    // Per-line undo/redo; every add, edit, toggle and delete is one step.
+    // Loading a serialized document clears the history.
+    bool undo();
+    bool redo();
+    void clearHistory();
+    size_t undoDepth() const { return undoRecords.size(); }
+    size_t redoDepth() const { return redoRecords.size(); }
+
     // Data conversion for encryption
     std::vector<char> serializeDocument();
     bool deserializeDocument(const std::vector<char>& data);
 
-    // Display functions
-    void printDocument();
-    void printLine(size_t lineIndex);
+    // Display functions, writing to out
+    void printDocument(std::ostream& out);
+    void printLine(std::ostream& out, size_t lineIndex);
 
     // Search functions
     std::vector<size_t> searchInDocument(const std::string& searchText);
+    std::vector<size_t> searchInDocumentRegex(const std::string& pattern);
+
+    // Optional trigram index that speeds up searchInDocument
+    void enableSearchIndex(bool enabled);
+    bool isSearchIndexEnabled() const;
 
     // Validation
     bool isValidLineIndex(size_t lineIndex) const;
@@ -46,7 +91,21 @@ private:
     void ensureCapacity(size_t requiredCapacity);
     void freeLine(size_t lineIndex);
     std::string serializeLine(size_t lineIndex);
+    bool parseDocument(const std::vector<char>& data);
     bool deserializeLine(const std::string& data, size_t lineIndex);
+    void captureLine(size_t lineIndex, LineState& state) const;
+    bool placeLine(size_t lineIndex, const LineState& state);
+    bool insertLineAt(size_t lineIndex, const LineState& state);
+    void removeLineAt(size_t lineIndex);
+    void recordLine(LineChange change, size_t lineIndex, LineState* before);
+    bool applyRecord(const LineRecord& record, bool forward);
+    std::vector<std::string> lineFields(size_t lineIndex) const;
+    bool lineContains(size_t lineIndex, const std::string& searchText) const;
+    void indexAppendedLine();
+    void indexUpdatedLine(size_t lineIndex);
+
+    DataTypeHandler(const DataTypeHandler&);
+    DataTypeHandler& operator=(const DataTypeHandler&);
 };
 
 #endif // DATA_TYPE_HANDLER_H
\ No newline at end of file
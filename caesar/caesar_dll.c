@@ -6,14 +6,22 @@
 #define EXPORT
 #endif
 
-// Simple Caesar cipher encryption function
-EXPORT void caesar_encrypt(const char* input, char* output, int key, int length) {
-    if (!input || !output || length <= 0) return;
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
 
-    // Normalize key to 0-25 range
-    key = ((key % 26) + 26) % 26;
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define CAESAR_SIMD 1
+#include <immintrin.h>
+#endif
 
-    for (int i = 0; i < length; i++) {
+// Shift kernels: each one rotates the letters of length bytes by key (0-25)
+// and copies everything else. They must produce exactly the same bytes, and
+// input may equal output.
+typedef void (*ShiftKernel)(const char* input, char* output, int key, size_t length);
+
+static void shift_scalar(const char* input, char* output, int key, size_t length) {
+    for (size_t i = 0; i < length; i++) {
         char c = input[i];
 
         if (c >= 'A' && c <= 'Z') {
@@ -29,12 +37,173 @@ EXPORT void caesar_encrypt(const char* input, char* output, int key, int length)
     }
 }
 
+#ifdef CAESAR_SIMD
+
+// The vector kernels work on every byte at once. Setting bit 5 folds upper
+// case onto lower case, so letter = (c | 0x20) - 'a' is 0-25 exactly for
+// letters of either case. Then shifted = letter + key, minus 26 when that
+// reaches 26 (min(s, s - 26) unsigned, as s - 26 wraps when s < 26), and
+// the letters get c + (shifted - letter).
+
+__attribute__((target("sse2")))
+static void shift_sse2(const char* input, char* output, int key, size_t length) {
+    const __m128i caseBit = _mm_set1_epi8(0x20);
+    const __m128i lowerA = _mm_set1_epi8('a');
+    const __m128i last = _mm_set1_epi8(25);
+    const __m128i alphabet = _mm_set1_epi8(26);
+    const __m128i shift = _mm_set1_epi8((char)key);
+    size_t i = 0;
+
+    for (; i + 16 <= length; i += 16) {
+        __m128i c = _mm_loadu_si128((const __m128i*)(input + i));
+        __m128i letter = _mm_sub_epi8(_mm_or_si128(c, caseBit), lowerA);
+        __m128i isLetter = _mm_cmpeq_epi8(_mm_min_epu8(letter, last), letter);
+        __m128i shifted = _mm_add_epi8(letter, shift);
+        shifted = _mm_min_epu8(shifted, _mm_sub_epi8(shifted, alphabet));
+        __m128i delta = _mm_and_si128(_mm_sub_epi8(shifted, letter), isLetter);
+        _mm_storeu_si128((__m128i*)(output + i), _mm_add_epi8(c, delta));
+    }
+    shift_scalar(input + i, output + i, key, length - i);
+}
+
+__attribute__((target("avx2")))
+static void shift_avx2(const char* input, char* output, int key, size_t length) {
+    const __m256i caseBit = _mm256_set1_epi8(0x20);
+    const __m256i lowerA = _mm256_set1_epi8('a');
+    const __m256i last = _mm256_set1_epi8(25);
+    const __m256i alphabet = _mm256_set1_epi8(26);
+    const __m256i shift = _mm256_set1_epi8((char)key);
+    size_t i = 0;
+
+    for (; i + 32 <= length; i += 32) {
+        __m256i c = _mm256_loadu_si256((const __m256i*)(input + i));
+        __m256i letter = _mm256_sub_epi8(_mm256_or_si256(c, caseBit), lowerA);
+        __m256i isLetter = _mm256_cmpeq_epi8(_mm256_min_epu8(letter, last), letter);
+        __m256i shifted = _mm256_add_epi8(letter, shift);
+        shifted = _mm256_min_epu8(shifted, _mm256_sub_epi8(shifted, alphabet));
+        __m256i delta = _mm256_and_si256(_mm256_sub_epi8(shifted, letter), isLetter);
+        _mm256_storeu_si256((__m256i*)(output + i), _mm256_add_epi8(c, delta));
+    }
+    shift_sse2(input + i, output + i, key, length - i);
+}
+
+// AVX-512BW compares straight into a mask register, and the tail is done
+// with a masked load and store instead of falling back to a narrower kernel
+__attribute__((target("avx512f,avx512bw")))
+static void shift_avx512(const char* input, char* output, int key, size_t length) {
+    const __m512i caseBit = _mm512_set1_epi8(0x20);
+    const __m512i lowerA = _mm512_set1_epi8('a');
+    const __m512i last = _mm512_set1_epi8(25);
+    const __m512i alphabet = _mm512_set1_epi8(26);
+    const __m512i shift = _mm512_set1_epi8((char)key);
+    size_t i = 0;
+
+    while (i < length) {
+        size_t remaining = length - i;
+        __mmask64 lanes = remaining >= 64 ? ~(__mmask64)0 : (((__mmask64)1 << remaining) - 1);
+
+        __m512i c = _mm512_maskz_loadu_epi8(lanes, input + i);
+        __m512i letter = _mm512_sub_epi8(_mm512_or_si512(c, caseBit), lowerA);
+        __mmask64 isLetter = _mm512_cmple_epu8_mask(letter, last);
+        __m512i shifted = _mm512_add_epi8(letter, shift);
+        shifted = _mm512_min_epu8(shifted, _mm512_sub_epi8(shifted, alphabet));
+        __m512i result = _mm512_mask_add_epi8(c, isLetter, c, _mm512_sub_epi8(shifted, letter));
+        _mm512_mask_storeu_epi8(output + i, lanes, result);
+        i += 64;
+    }
+}
+
+#endif // CAESAR_SIMD
+
+static ShiftKernel shiftKernel = shift_scalar;
+static const char* shiftKernelName = "scalar";
+
+// Pick the widest kernel the CPU supports. CAESAR_KERNEL=scalar|sse2|avx2|
+// avx512 caps the choice, which is how the kernels are compared.
+static void select_kernel(void) {
+    const char* cap = getenv("CAESAR_KERNEL");
+    int limit = 3;
+
+    if (cap) {
+        if (strcmp(cap, "scalar") == 0) limit = 0;
+        else if (strcmp(cap, "sse2") == 0) limit = 1;
+        else if (strcmp(cap, "avx2") == 0) limit = 2;
+    }
+
+    shiftKernel = shift_scalar;
+    shiftKernelName = "scalar";
+#ifdef CAESAR_SIMD
+    __builtin_cpu_init();
+    if (limit >= 3 && __builtin_cpu_supports("avx512bw")) {
+        shiftKernel = shift_avx512;
+        shiftKernelName = "avx512";
+    } else if (limit >= 2 && __builtin_cpu_supports("avx2")) {
+        shiftKernel = shift_avx2;
+        shiftKernelName = "avx2";
+    } else if (limit >= 1 && __builtin_cpu_supports("sse2")) {
+        shiftKernel = shift_sse2;
+        shiftKernelName = "sse2";
+    }
+#else
+    (void)limit;
+#endif
+}
+
+#ifdef __GNUC__
+__attribute__((constructor))
+static void caesar_load(void) {
+    select_kernel();
+}
+#endif
+
+// Name of the kernel picked at load time
+EXPORT const char* caesar_kernel(void) {
+    return shiftKernelName;
+}
+
+// Normalize a key to the 0-25 shift that encrypts with it
+static int encryption_shift(int key) {
+    return ((key % 26) + 26) % 26;
+}
+
+static int decryption_shift(int key) {
+    return (26 - encryption_shift(key)) % 26;
+}
+
+// Simple Caesar cipher encryption function
+EXPORT void caesar_encrypt(const char* input, char* output, int key, int length) {
+    if (!input || !output || length <= 0) return;
+
+    shiftKernel(input, output, encryption_shift(key), (size_t)length);
+}
+
 // Simple Caesar cipher decryption function
 EXPORT void caesar_decrypt(const char* input, char* output, int key, int length) {
     if (!input || !output || length <= 0) return;
 
-    // For decryption, we use the negative key
-    caesar_encrypt(input, output, -key, length);
+    shiftKernel(input, output, decryption_shift(key), (size_t)length);
+}
+
+// (pointer, length) variants for any size: output is provided by the caller
+// and may be input itself
+EXPORT void caesar_encrypt_into(const char* input, char* output, size_t length, int key) {
+    if (!input || !output || length == 0) return;
+
+    shiftKernel(input, output, encryption_shift(key), length);
+}
+
+EXPORT void caesar_decrypt_into(const char* input, char* output, size_t length, int key) {
+    if (!input || !output || length == 0) return;
+
+    shiftKernel(input, output, decryption_shift(key), length);
+}
+
+EXPORT void caesar_encrypt_inplace(char* data, size_t length, int key) {
+    caesar_encrypt_into(data, data, length, key);
+}
+
+EXPORT void caesar_decrypt_inplace(char* data, size_t length, int key) {
+    caesar_decrypt_into(data, data, length, key);
 }
 
 // Optional: DLL entry point for Windows
@@ -44,6 +213,8 @@ EXPORT void caesar_decrypt(const char* input, char* output, int key, int length)
     BOOL APIENTRY DllMain(HMODULE hModule, DWORD ul_reason_for_call, LPVOID lpReserved) {
         switch (ul_reason_for_call) {
             case DLL_PROCESS_ATTACH:
+                select_kernel();
+                break;
             case DLL_THREAD_ATTACH:
             case DLL_THREAD_DETACH:
             case DLL_PROCESS_DETACH:
@@ -0,0 +1,133 @@
+#include "AhoCorasick.h"
+#include "TextSearch.h"
+#include <algorithm>
+#include <cstring>
+
+static bool matchBefore(const SearchMatch& a, const SearchMatch& b) {
+    if (a.offset != b.offset) return a.offset < b.offset;
+    return a.patternId < b.patternId;
+}
+
+AhoCorasick::AhoCorasick(const std::vector<std::string>& patterns) : classCount(1) {
+    build(patterns);
+}
+
+int AhoCorasick::addState() {
+    int state = (int)terminal.size();
+    transitions.resize(transitions.size() + classCount, -1);
+    terminal.push_back(-1);
+    outputLink.push_back(-1);
+    return state;
+}
+
+void AhoCorasick::build(const std::vector<std::string>& patterns) {
+    // Byte classes: 0 is "not in any pattern"
+    memset(byteClass, 0, sizeof(byteClass));
+    for (size_t i = 0; i < patterns.size(); i++) {
+        for (size_t j = 0; j < patterns[i].size(); j++) {
+            unsigned char byte = (unsigned char)patterns[i][j];
+            if (byteClass[byte] == 0) {
+                byteClass[byte] = (unsigned char)classCount++;
+            }
+        }
+    }
+
+    // All 256 byte values in use would overflow the class id
+    if (classCount > 256) {
+        for (int i = 0; i < 256; i++) {
+            byteClass[i] = (unsigned char)i;
+        }
+        classCount = 256;
+    }
+
+    addState();
+    lengths.resize(patterns.size());
+    nextSamePattern.assign(patterns.size(), -1);
+
+    // Trie
+    for (size_t i = 0; i < patterns.size(); i++) {
+        lengths[i] = patterns[i].size();
+        if (patterns[i].empty()) continue;
+
+        int state = 0;
+        for (size_t j = 0; j < patterns[i].size(); j++) {
+            size_t slot = state * classCount + byteClass[(unsigned char)patterns[i][j]];
+            if (transitions[slot] < 0) {
+                int next = addState();
+                transitions[slot] = next;
+            }
+            state = transitions[slot];
+        }
+
+        nextSamePattern[i] = terminal[state];
+        terminal[state] = (int)i;
+    }
+
+    // Breadth-first pass: resolve failures into direct transitions
+    std::vector<int> failure(terminal.size(), 0);
+    std::vector<int> queue;
+    queue.reserve(terminal.size());
+
+    for (size_t c = 0; c < classCount; c++) {
+        int next = transitions[c];
+        if (next < 0) {
+            transitions[c] = 0;
+        } else {
+            failure[next] = 0;
+            queue.push_back(next);
+        }
+    }
+
+    for (size_t head = 0; head < queue.size(); head++) {
+        int state = queue[head];
+        int fallback = failure[state];
+        outputLink[state] = terminal[fallback] >= 0 ? fallback : outputLink[fallback];
+
+        for (size_t c = 0; c < classCount; c++) {
+            size_t slot = state * classCount + c;
+            int next = transitions[slot];
+            if (next < 0) {
+                transitions[slot] = transitions[fallback * classCount + c];
+            } else {
+                failure[next] = transitions[fallback * classCount + c];
+                queue.push_back(next);
+            }
+        }
+    }
+}
+
+std::vector<SearchMatch> AhoCorasick::findAll(const char* text, size_t length) const {
+    std::vector<SearchMatch> matches;
+    if (!text || lengths.empty()) return matches;
+
+    const int* table = transitions.data();
+    int state = 0;
+
+    for (size_t i = 0; i < length; i++) {
+        state = table[state * classCount + byteClass[(unsigned char)text[i]]];
+
+        int hit = terminal[state] >= 0 ? state : outputLink[state];
+        for (; hit >= 0; hit = outputLink[hit]) {
+            for (int id = terminal[hit]; id >= 0; id = nextSamePattern[id]) {
+                SearchMatch match;
+                match.offset = i + 1 - lengths[id];
+                match.line = 0;
+                match.column = 0;
+                match.length = lengths[id];
+                match.patternId = (size_t)id;
+                matches.push_back(match);
+            }
+        }
+    }
+
+    // Longer patterns end later but may start earlier, so order by start
+    // before walking the line counters forward once.
+    std::sort(matches.begin(), matches.end(), matchBefore);
+
+    LineCursor cursor(text);
+    for (size_t i = 0; i < matches.size(); i++) {
+        cursor.advanceTo(matches[i].offset, matches[i]);
+    }
+
+    return matches;
+}
@@ -0,0 +1,37 @@
+#ifndef AHO_CORASICK_H
+#define AHO_CORASICK_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "TextEditorApi.h"
+
+// Multi-pattern matcher. The pattern set is compiled once into a full DFA
+// whose columns are byte equivalence classes (bytes that never occur in a
+// pattern share one class), which keeps the transition table small enough to
+// stay in cache. A scan then reports every match in a single pass.
+class AhoCorasick {
+private:
+    unsigned char byteClass[256];
+    size_t classCount;
+
+    std::vector<int> transitions;     // stateCount x classCount
+    std::vector<int> terminal;        // first pattern ending at a state, or -1
+    std::vector<int> outputLink;      // nearest suffix state with output, or -1
+    std::vector<int> nextSamePattern; // duplicate patterns ending at the same state
+    std::vector<size_t> lengths;
+
+    int addState();
+    void build(const std::vector<std::string>& patterns);
+
+public:
+    explicit AhoCorasick(const std::vector<std::string>& patterns);
+
+    size_t patternCount() const { return lengths.size(); }
+    size_t stateCount() const { return terminal.size(); }
+
+    // Every (possibly overlapping) match, ordered by offset then pattern id
+    std::vector<SearchMatch> findAll(const char* text, size_t length) const;
+};
+
+#endif // AHO_CORASICK_H
@@ -0,0 +1,165 @@
+#include "AtomicFileWriter.h"
+#include <cerrno>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#ifndef IOV_MAX
+#define IOV_MAX 1024
+#endif
+
+AtomicFileWriter::AtomicFileWriter(const std::string& path) : targetPath(path), fd(-1), written(0) {
+}
+
+AtomicFileWriter::~AtomicFileWriter() {
+    abort();
+}
+
+void AtomicFileWriter::abort() {
+    if (fd >= 0) {
+        close(fd);
+        fd = -1;
+        unlink(tempPath.c_str());
+    }
+}
+
+bool AtomicFileWriter::open() {
+    abort();
+    written = 0;
+
+    std::vector<char> pattern(targetPath.begin(), targetPath.end());
+    const char suffix[] = ".tmp.XXXXXX";
+    pattern.insert(pattern.end(), suffix, suffix + sizeof(suffix));
+
+    fd = mkstemp(pattern.data());
+    if (fd < 0) return false;
+    tempPath = pattern.data();
+
+    // mkstemp creates 0600; keep the target's mode, or the usual default
+    struct stat info;
+    mode_t mode;
+    if (stat(targetPath.c_str(), &info) == 0) {
+        mode = info.st_mode & 07777;
+    } else {
+        mode_t mask = umask(0);
+        umask(mask);
+        mode = 0666 & ~mask;
+    }
+    fchmod(fd, mode);
+    return true;
+}
+
+bool AtomicFileWriter::write(const char* data, size_t length) {
+    std::vector<Segment> segments(1, Segment(data, length));
+    return write(segments);
+}
+
+bool AtomicFileWriter::write(const std::vector<Segment>& segments) {
+    if (fd < 0) return false;
+
+    // Keep each writev well below SSIZE_MAX, also on 32-bit systems
+    const size_t maxBatch = (size_t)1 << 30;
+    std::vector<struct iovec> vectors;
+    size_t index = 0;
+    size_t offset = 0;
+
+    while (index < segments.size()) {
+        vectors.clear();
+        size_t batch = 0;
+        while (index < segments.size() && vectors.size() < IOV_MAX && batch < maxBatch) {
+            size_t length = segments[index].second - offset;
+            if (length > maxBatch - batch) {
+                length = maxBatch - batch;
+            }
+            if (length > 0) {
+                struct iovec vector;
+                vector.iov_base = const_cast<char*>(segments[index].first + offset);
+                vector.iov_len = length;
+                vectors.push_back(vector);
+                batch += length;
+                offset += length;
+            }
+            if (offset == segments[index].second) {
+                index++;
+                offset = 0;
+            }
+        }
+
+        // writev may stop early; advance through the iovecs and retry
+        size_t first = 0;
+        while (first < vectors.size()) {
+            ssize_t result = writev(fd, &vectors[first], (int)(vectors.size() - first));
+            if (result < 0) {
+                if (errno == EINTR) continue;
+                return false;
+            }
+
+            size_t done = (size_t)result;
+            written += done;
+            while (first < vectors.size() && done >= vectors[first].iov_len) {
+                done -= vectors[first].iov_len;
+                first++;
+            }
+            if (first < vectors.size()) {
+                vectors[first].iov_base = static_cast<char*>(vectors[first].iov_base) + done;
+                vectors[first].iov_len -= done;
+            }
+        }
+    }
+
+    return true;
+}
+
+bool AtomicFileWriter::writeAt(const char* data, size_t length, size_t offset) {
+    if (fd < 0) return false;
+
+    while (length > 0) {
+        ssize_t result = pwrite(fd, data, length, (off_t)offset);
+        if (result < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data += result;
+        length -= (size_t)result;
+        offset += (size_t)result;
+    }
+    return true;
+}
+
+bool AtomicFileWriter::commit() {
+    if (fd < 0) return false;
+
+    if (fsync(fd) != 0) {
+        abort();
+        return false;
+    }
+    if (close(fd) != 0) {
+        fd = -1;
+        unlink(tempPath.c_str());
+        return false;
+    }
+    fd = -1;
+
+    if (rename(tempPath.c_str(), targetPath.c_str()) != 0) {
+        unlink(tempPath.c_str());
+        return false;
+    }
+
+    // Persist the rename itself
+    std::string directory = ".";
+    size_t slash = targetPath.find_last_of('/');
+    if (slash != std::string::npos) {
+        directory = slash == 0 ? "/" : targetPath.substr(0, slash);
+    }
+    int directoryFd = ::open(directory.c_str(), O_RDONLY);
+    if (directoryFd >= 0) {
+        fsync(directoryFd);
+        close(directoryFd);
+    }
+
+    return true;
+}
@@ -0,0 +1,44 @@
+#ifndef ATOMIC_FILE_WRITER_H
+#define ATOMIC_FILE_WRITER_H
+
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Crash-safe file replacement: data goes to a temporary file next to the
+// target, which is fsync'ed and then renamed over it. A crash at any point
+// leaves either the old file or the complete new one, never a torn mix.
+class AtomicFileWriter {
+public:
+    typedef std::pair<const char*, size_t> Segment;
+
+private:
+    std::string targetPath;
+    std::string tempPath;
+    int fd;
+    size_t written;
+
+    void abort();
+
+public:
+    explicit AtomicFileWriter(const std::string& path);
+    ~AtomicFileWriter();   // removes the temporary file unless committed
+
+    bool open();
+    bool write(const char* data, size_t length);
+    bool write(const std::vector<Segment>& segments);   // gathered with writev
+
+    // Positional write for filling the file from several threads at once,
+    // each with its own range; not counted in bytesWritten
+    bool writeAt(const char* data, size_t length, size_t offset);
+    bool commit();
+
+    size_t bytesWritten() const { return written; }
+
+private:
+    AtomicFileWriter(const AtomicFileWriter&);
+    AtomicFileWriter& operator=(const AtomicFileWriter&);
+};
+
+#endif // ATOMIC_FILE_WRITER_H
@@ -0,0 +1,254 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "../main.h"
+
+// Batch mode (see main): runs a script of editor commands with no prompts
+// and no per-command output, then prints a timing summary to stderr. One
+// command per line, '#' starts a comment, L C are a line and column:
+//
+//   append TEXT            newline
+//   insert L C TEXT        replace L C TEXT       delete L C N
+//   copy L C N [REG]       cut L C N [REG]        paste L C [REG]
+//   search TEXT            regex PATTERN
+//   undo                   redo
+//   encrypt K              decrypt K
+//   load PATH              save PATH              print
+//
+// TEXT runs to the end of the line and understands \n, \t, \r and \\.
+// Every command is its own undo step: edits are not merged across commands
+// the way the menu merges continued typing. Failed commands are reported with
+// their script line and do not stop the run.
+
+namespace {
+
+struct CommandStats {
+    const char* name;
+    size_t count;
+    size_t failed;
+    double seconds;
+};
+
+// Splits one script line into words, leaving the rest available as text
+class LineParser {
+private:
+    const std::string& line;
+    size_t cursor;
+
+public:
+    explicit LineParser(const std::string& text) : line(text), cursor(0) {}
+
+    bool word(std::string& output) {
+        while (cursor < line.size() && (line[cursor] == ' ' || line[cursor] == '\t')) cursor++;
+        if (cursor == line.size()) return false;
+
+        size_t start = cursor;
+        while (cursor < line.size() && line[cursor] != ' ' && line[cursor] != '\t') cursor++;
+        output.assign(line, start, cursor - start);
+        return true;
+    }
+
+    bool number(size_t& value) {
+        std::string digits;
+        if (!word(digits)) return false;
+
+        char* end;
+        value = (size_t)strtoull(digits.c_str(), &end, 10);
+        return *end == '\0' && digits[0] != '-';
+    }
+
+    bool optionalRegister(char& name) {
+        std::string token;
+        name = 0;
+        if (!word(token)) return true;
+        if (token.size() != 1) return false;
+        name = token[0];
+        return true;
+    }
+
+    // Everything after the single separator that follows the last word
+    void text(std::string& output) {
+        if (cursor < line.size() && (line[cursor] == ' ' || line[cursor] == '\t')) cursor++;
+
+        output.clear();
+        for (size_t i = cursor; i < line.size(); i++) {
+            char c = line[i];
+            if (c == '\\' && i + 1 < line.size()) {
+                char next = line[++i];
+                if (next == 'n') c = '\n';
+                else if (next == 't') c = '\t';
+                else if (next == 'r') c = '\r';
+                else c = next;
+            }
+            output.push_back(c);
+        }
+        cursor = line.size();
+    }
+};
+
+bool readPosition(LineParser& parser, size_t& line, size_t& column) {
+    return parser.number(line) && parser.number(column);
+}
+
+size_t countMatches(TextBuffer* buffer, const std::string& pattern, bool regex) {
+    SearchResults results;
+    int status = regex ? editorSearchRegex(buffer, pattern.data(), pattern.size(), &results)
+                       : editorSearch(buffer, pattern.data(), pattern.size(), &results);
+    if (status != EDITOR_OK) return (size_t)-1;
+
+    size_t count = results.count;
+    freeSearchResults(&results);
+    return count;
+}
+
+// Runs one command; false when it failed
+bool runCommand(TextBuffer* buffer, const std::string& command, LineParser& parser, size_t& matches) {
+    std::string text;
+    size_t line, column, length;
+    char name;
+
+    if (command == "append") {
+        parser.text(text);
+        return editorAppend(buffer, text.data(), text.size()) == EDITOR_OK;
+    }
+    if (command == "newline") {
+        return editorAppend(buffer, "\n", 1) == EDITOR_OK;
+    }
+    if (command == "insert" || command == "replace") {
+        if (!readPosition(parser, line, column)) return false;
+        parser.text(text);
+        return command == "insert" ? editorInsert(buffer, line, column, text.data(), text.size()) == EDITOR_OK
+                                   : editorReplace(buffer, line, column, text.data(), text.size()) == EDITOR_OK;
+    }
+    if (command == "delete") {
+        if (!readPosition(parser, line, column) || !parser.number(length)) return false;
+        return editorDelete(buffer, line, column, length, nullptr) == EDITOR_OK;
+    }
+    if (command == "copy" || command == "cut") {
+        if (!readPosition(parser, line, column) || !parser.number(length) || !parser.optionalRegister(name)) {
+            return false;
+        }
+        return command == "copy" ? editorCopy(buffer, line, column, length, name, nullptr) == EDITOR_OK
+                                 : editorCut(buffer, line, column, length, name, nullptr) == EDITOR_OK;
+    }
+    if (command == "paste") {
+        if (!readPosition(parser, line, column) || !parser.optionalRegister(name)) return false;
+        return editorPaste(buffer, line, column, name, nullptr) == EDITOR_OK;
+    }
+    if (command == "search" || command == "regex") {
+        parser.text(text);
+        if (text.empty()) return false;
+        size_t found = countMatches(buffer, text, command == "regex");
+        if (found == (size_t)-1) return false;
+        matches += found;
+        return true;
+    }
+    if (command == "undo") {
+        return editorUndo(buffer) == EDITOR_OK;
+    }
+    if (command == "redo") {
+        return editorRedo(buffer) == EDITOR_OK;
+    }
+    if (command == "encrypt" || command == "decrypt") {
+        std::string key;
+        char* end;
+        if (!parser.word(key)) return false;
+        long value = strtol(key.c_str(), &end, 10);
+        if (*end != '\0') return false;
+        return command == "encrypt" ? editorEncrypt(buffer, (int)value) == EDITOR_OK
+                                    : editorDecrypt(buffer, (int)value) == EDITOR_OK;
+    }
+    if (command == "load" || command == "save") {
+        parser.text(text);
+        if (text.empty()) return false;
+        return command == "load" ? editorLoad(buffer, text.c_str()) == EDITOR_OK
+                                 : editorSave(buffer, text.c_str(), nullptr, nullptr) == EDITOR_OK;
+    }
+    if (command == "print") {
+        const char* content;
+        if (editorText(buffer, &content, &length) != EDITOR_OK) return false;
+        return fwrite(content, 1, length, stdout) == length;
+    }
+    return false;
+}
+
+} // namespace
+
+extern "C" int runBatchScript(TextBuffer* buffer, const char* path) {
+    std::ifstream file;
+    bool fromStdin = !path || std::string(path) == "-";
+    if (!fromStdin) {
+        file.open(path);
+        if (!file.is_open()) {
+            std::cerr << "Failed to open batch script: " << path << std::endl;
+            return -1;
+        }
+    }
+    std::istream& script = fromStdin ? std::cin : file;
+    bufferSetCoalescing(buffer, 0);
+
+    static const char* const names[] = {"append", "newline", "insert", "replace", "delete", "copy", "cut",
+                                        "paste",  "search",  "regex",  "undo",    "redo",   "encrypt",
+                                        "decrypt", "load",   "save",   "print"};
+    std::vector<CommandStats> stats;
+    for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+        CommandStats entry = {names[i], 0, 0, 0};
+        stats.push_back(entry);
+    }
+
+    size_t commands = 0, failures = 0, matches = 0, lineNumber = 0;
+    std::string line, command;
+    std::chrono::steady_clock::time_point runStart = std::chrono::steady_clock::now();
+
+    while (std::getline(script, line)) {
+        lineNumber++;
+        if (!line.empty() && line[line.size() - 1] == '\r') line.erase(line.size() - 1);
+
+        LineParser parser(line);
+        if (!parser.word(command) || command[0] == '#') continue;
+
+        CommandStats* entry = nullptr;
+        for (size_t i = 0; i < stats.size(); i++) {
+            if (command == stats[i].name) entry = &stats[i];
+        }
+        commands++;
+        if (!entry) {
+            failures++;
+            std::cerr << "line " << lineNumber << ": unknown command '" << command << "'" << std::endl;
+            continue;
+        }
+
+        bufferCheckpoint(buffer);
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        bool succeeded = runCommand(buffer, command, parser, matches);
+        entry->seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        entry->count++;
+
+        if (!succeeded) {
+            entry->failed++;
+            failures++;
+            std::cerr << "line " << lineNumber << ": " << command << " failed" << std::endl;
+        }
+    }
+    fflush(stdout);
+
+    double total = std::chrono::duration<double>(std::chrono::steady_clock::now() - runStart).count();
+    fprintf(stderr, "Batch: %zu command(s), %zu failed, %.3f s", commands, failures, total);
+    if (total > 0) {
+        fprintf(stderr, " (%.0f commands/s)", commands / total);
+    }
+    fprintf(stderr, "\n%-8s %9s %7s %11s %11s\n", "command", "count", "failed", "total ms", "mean us");
+    for (size_t i = 0; i < stats.size(); i++) {
+        if (stats[i].count == 0) continue;
+        fprintf(stderr, "%-8s %9zu %7zu %11.2f %11.2f\n", stats[i].name, stats[i].count, stats[i].failed,
+                stats[i].seconds * 1000, stats[i].seconds * 1e6 / stats[i].count);
+    }
+    fprintf(stderr, "Matches found: %zu\nFinal text: %zu bytes, %zu line(s)\n", matches, buffer->used,
+            bufferLineCount(buffer));
+
+    return failures == 0 ? 0 : -1;
+}
@@ -0,0 +1,153 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+#include "ParallelSearch.h"
+#include "TextSearch.h"
+#include "ThreadPool.h"
+#include "../caesar/CaesarCipher.h"
+#include "../main.h"
+
+// Command line benchmarks (see main). They print a small table so runs on
+// different machines can be compared directly.
+
+static bool readWholeFile(const char* path, std::string& content) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) return false;
+
+    content.assign((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    return true;
+}
+
+static double secondsSince(const std::chrono::steady_clock::time_point& start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+extern "C" int runSearchBenchmark(const char* path, const char* pattern, size_t maxThreads) {
+    std::string content;
+    if (!readWholeFile(path, content)) {
+        std::cerr << "Failed to open benchmark file: " << path << std::endl;
+        return -1;
+    }
+    if (maxThreads == 0) {
+        maxThreads = ThreadPool::hardwareThreads();
+    }
+
+    const int repetitions = 3;
+    double megabytes = content.size() / (1024.0 * 1024.0);
+    std::cout << "Searching " << megabytes << " MB for '" << pattern << "'" << std::endl;
+
+    // Single-threaded baseline
+    TextSearch search(pattern);
+    double baseline = 0;
+    size_t expected = 0;
+    for (int i = 0; i < repetitions; i++) {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        expected = search.findAll(content.data(), content.size()).size();
+        double elapsed = secondsSince(start);
+        if (i == 0 || elapsed < baseline) baseline = elapsed;
+    }
+
+    printf("threads        ms      MB/s   speedup   matches\n");
+    printf("%7s %9.2f %9.1f %9.2f %9zu\n", "seq", baseline * 1000, megabytes / baseline, 1.0, expected);
+
+    for (size_t threads = 1; threads <= maxThreads; threads++) {
+        ParallelSearch parallel(pattern, threads);
+        double best = 0;
+        size_t found = 0;
+        for (int i = 0; i < repetitions; i++) {
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            found = parallel.findAll(content.data(), content.size()).size();
+            double elapsed = secondsSince(start);
+            if (i == 0 || elapsed < best) best = elapsed;
+        }
+
+        printf("%7zu %9.2f %9.1f %9.2f %9zu%s\n", threads, best * 1000, megabytes / best,
+               baseline / best, found, found == expected ? "" : "  MISMATCH");
+    }
+
+    return 0;
+}
+
+// FNV-1a over a file read in chunks, or over a chunk added to a running hash
+static uint64_t hashBytes(uint64_t hash, const char* data, size_t length) {
+    for (size_t i = 0; i < length; i++) {
+        hash = (hash ^ (unsigned char)data[i]) * 1099511628211ULL;
+    }
+    return hash;
+}
+
+static const uint64_t HASH_SEED = 14695981039346656037ULL;
+
+static bool hashFile(const char* path, uint64_t& hash, CaesarCipher* cipher, int key) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) return false;
+
+    std::vector<char> chunk(CaesarCipher::FILE_CHUNK_SIZE);
+    hash = HASH_SEED;
+    while (file.read(chunk.data(), chunk.size()) || file.gcount() > 0) {
+        size_t count = (size_t)file.gcount();
+        if (cipher) cipher->encryptInPlace(chunk.data(), count, key);
+        hash = hashBytes(hash, chunk.data(), count);
+    }
+    return true;
+}
+
+extern "C" int runEncryptBenchmark(const char* path, size_t maxThreads) {
+    CaesarCipher cipher;
+    if (!cipher.isReady()) {
+        std::cerr << "Caesar cipher is not ready; cannot benchmark encryption. " << cipher.loadError() << std::endl;
+        return -1;
+    }
+
+    const int key = 3;
+    uint64_t expected;
+    if (!hashFile(path, expected, &cipher, key)) {
+        std::cerr << "Failed to open benchmark file: " << path << std::endl;
+        return -1;
+    }
+    if (maxThreads == 0) {
+        maxThreads = ThreadPool::hardwareThreads();
+    }
+
+    std::ifstream sizeProbe(path, std::ios::binary | std::ios::ate);
+    double megabytes = (double)sizeProbe.tellg() / (1024.0 * 1024.0);
+    sizeProbe.close();
+
+    // Every run writes, fsyncs and renames a real output file, as a job would
+    std::string output = std::string(path) + ".bench";
+    const int repetitions = 3;
+    std::cout << "Encrypting " << megabytes << " MB to " << output << std::endl;
+
+    printf("threads        ms      MB/s   speedup\n");
+    double single = 0;
+    int status = 0;
+    for (size_t threads = 1; threads <= maxThreads; threads++) {
+        double best = 0;
+        for (int i = 0; i < repetitions; i++) {
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            if (!cipher.encryptFileParallel(path, output, key, threads)) {
+                std::cerr << editorLastError() << std::endl;
+                remove(output.c_str());
+                return -1;
+            }
+            double elapsed = secondsSince(start);
+            if (i == 0 || elapsed < best) best = elapsed;
+        }
+        if (threads == 1) single = best;
+
+        uint64_t produced = 0;
+        bool matches = hashFile(output.c_str(), produced, nullptr, 0) && produced == expected;
+        if (!matches) status = -1;
+
+        printf("%7zu %9.2f %9.1f %9.2f%s\n", threads, best * 1000, megabytes / best, single / best,
+               matches ? "" : "  MISMATCH");
+    }
+
+    remove(output.c_str());
+    return status;
+}
@@ -0,0 +1,68 @@
+#ifndef BOUNDED_QUEUE_H
+#define BOUNDED_QUEUE_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <utility>
+
+// Blocking FIFO between pipeline stages. push waits while the queue is
+// full, so a fast producer can only run capacity items ahead of its
+// consumers; pop waits while it is empty. After close, pushes fail and pops
+// drain what is left, then fail.
+template <typename T>
+class BoundedQueue {
+private:
+    std::deque<T> items;
+    size_t capacity;
+    bool closed;
+    std::mutex mutex;
+    std::condition_variable notFull;
+    std::condition_variable notEmpty;
+
+public:
+    explicit BoundedQueue(size_t capacity) : capacity(capacity ? capacity : 1), closed(false) {}
+
+    bool push(T&& item) {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (items.size() >= capacity && !closed) {
+            notFull.wait(lock);
+        }
+        if (closed) return false;
+
+        items.push_back(std::move(item));
+        lock.unlock();
+        notEmpty.notify_one();
+        return true;
+    }
+
+    bool pop(T& item) {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (items.empty() && !closed) {
+            notEmpty.wait(lock);
+        }
+        if (items.empty()) return false;
+
+        item = std::move(items.front());
+        items.pop_front();
+        lock.unlock();
+        notFull.notify_one();
+        return true;
+    }
+
+    void close() {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            closed = true;
+        }
+        notFull.notify_all();
+        notEmpty.notify_all();
+    }
+
+private:
+    BoundedQueue(const BoundedQueue&);
+    BoundedQueue& operator=(const BoundedQueue&);
+};
+
+#endif // BOUNDED_QUEUE_H
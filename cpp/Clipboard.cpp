@@ -0,0 +1,59 @@
+#include "Clipboard.h"
+
+Clipboard::Clip::Clip() : offset(0), size(0), reference(false) {
+}
+
+Clipboard::Clip::Clip(const PieceTable& table, size_t position, size_t length)
+    : offset(0), size(length), reference(length >= REFERENCE_SIZE) {
+    if (reference) {
+        source = table.snapshot();
+        offset = position;
+    } else {
+        text.resize(length);
+        table.copyRange(position, length, &text[0]);
+    }
+}
+
+void Clipboard::Clip::read(size_t from, size_t length, char* output) const {
+    if (from > size || length > size - from) return;
+
+    if (reference) {
+        source.copyRange(offset + from, length, output);
+    } else {
+        text.copy(output, length, from);
+    }
+}
+
+bool Clipboard::isNamedRegister(char name) {
+    return name >= 'a' && name <= 'z';
+}
+
+bool Clipboard::isRegister(char name) {
+    return isNamedRegister(name) || (name >= '0' && name <= '9');
+}
+
+bool Clipboard::copy(const PieceTable& table, size_t position, size_t length, char name) {
+    if (name != 0 && !isNamedRegister(name)) return false;
+    if (length == 0 || position > table.length() || length > table.length() - position) return false;
+
+    ring.push_front(Clip(table, position, length));
+    if (ring.size() > RING_SIZE) {
+        ring.pop_back();
+    }
+    if (name) {
+        named[name - 'a'] = ring.front();
+    }
+    return true;
+}
+
+const Clipboard::Clip* Clipboard::find(char name) const {
+    if (name == 0) name = '0';
+    if (!isRegister(name)) return nullptr;
+
+    if (isNamedRegister(name)) {
+        const Clip& clip = named[name - 'a'];
+        return clip.length() > 0 ? &clip : nullptr;
+    }
+    size_t index = (size_t)(name - '0');
+    return index < ring.size() ? &ring[index] : nullptr;
+}
@@ -0,0 +1,57 @@
+#ifndef CLIPBOARD_H
+#define CLIPBOARD_H
+
+#include <cstddef>
+#include <deque>
+#include <string>
+#include "PieceTable.h"
+
+// Clipboard with named registers and a kill ring.
+//
+// Registers 'a'..'z' keep what was copied into them by name. Every copy or
+// cut also goes to the kill ring, which holds the last RING_SIZE of them as
+// registers '0'..'9' ('0' is the newest and the default for pasting).
+//
+// Small clips are copied. Larger ones keep a snapshot of the piece table and
+// the range within it instead: taking one is O(1) and shares the text's
+// buffers, so it only costs memory once later edits copy the nodes it shares.
+class Clipboard {
+public:
+    static const size_t RING_SIZE = 10;
+    static const size_t REFERENCE_SIZE = 4096;   // clips this long reference the text
+
+    class Clip {
+    private:
+        std::string text;
+        PieceTable::Snapshot source;
+        size_t offset;
+        size_t size;
+        bool reference;
+
+    public:
+        Clip();
+        Clip(const PieceTable& table, size_t position, size_t length);
+
+        size_t length() const { return size; }
+        bool isReference() const { return reference; }
+        void read(size_t from, size_t length, char* output) const;
+    };
+
+    // Copy a range of the table into the kill ring and, when name is a
+    // letter, into that register too. name 0 means the kill ring only.
+    bool copy(const PieceTable& table, size_t position, size_t length, char name);
+
+    // nullptr when the register is empty; name 0 is the newest ring entry
+    const Clip* find(char name) const;
+
+    // 'a'..'z' can be copied into; '0'..'9' name ring entries, which can
+    // only be read
+    static bool isNamedRegister(char name);
+    static bool isRegister(char name);
+
+private:
+    Clip named[26];
+    std::deque<Clip> ring;
+};
+
+#endif // CLIPBOARD_H
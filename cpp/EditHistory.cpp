@@ -0,0 +1,350 @@
+#include "EditHistory.h"
+#include "LzCodec.h"
+
+namespace {
+
+void writeNumber(std::string& output, size_t value) {
+    while (value >= 0x80) {
+        output.push_back((char)(value | 0x80));
+        value >>= 7;
+    }
+    output.push_back((char)value);
+}
+
+bool readNumber(const std::string& input, size_t& cursor, size_t& value) {
+    value = 0;
+    for (int shift = 0; cursor < input.size() && shift < 64; shift += 7) {
+        unsigned char byte = (unsigned char)input[cursor++];
+        value |= (size_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) return true;
+    }
+    return false;
+}
+
+} // namespace
+
+EditHistory::EditHistory(size_t budget)
+    : entryOpen(false), coalescable(false), coalescing(true), transactionDepth(0), budget(budget), storedBytes(0), coldEntries(0), coldRawBytes(0), coldBytes(0),
+      evictedEntries(0) {
+}
+
+size_t EditHistory::storedSize(const Entry& entry) {
+    return entry.cold ? entry.packed.size() : entry.rawBytes;
+}
+
+EditHistory::Entry& EditHistory::currentEntry() {
+    // A new edit makes everything that was undone unreachable
+    clearRedo();
+
+    if (!entryOpen) {
+        undoEntries.push_back(Entry());
+        entryOpen = true;
+        coalescable = transactionDepth == 0;
+        coolDown();
+    }
+    return undoEntries.back();
+}
+
+// Whether an edit picks up where the closed newest entry left off: an insert
+// at the end of its inserted text, or an erase at or just before its erase
+bool EditHistory::continuesLastEntry(size_t position, size_t length, bool insert) const {
+    if (entryOpen || !coalescing || !coalescable || undoEntries.empty()) return false;
+
+    const Entry& last = undoEntries.back();
+    if (last.cold || last.hasReplacement || last.operations.size() != 1) return false;
+    if (last.rawBytes + length > COALESCE_BYTES) return false;
+
+    const Operation& operation = last.operations[0];
+    if (insert) {
+        return operation.removed.empty() && operation.position + operation.inserted.size() == position;
+    }
+    return operation.inserted.empty() && (operation.position == position || position + length == operation.position);
+}
+
+void EditHistory::addBytes(Entry& entry, size_t bytes) {
+    entry.rawBytes += bytes;
+    storedBytes += bytes;
+    enforceBudget();
+}
+
+// Pack an entry's operations into one compressed string
+void EditHistory::freeze(Entry& entry) {
+    if (entry.cold || entry.hasReplacement || entry.rawBytes == 0) return;
+
+    std::string serialized;
+    serialized.reserve(entry.rawBytes + entry.operations.size() * 6);
+    writeNumber(serialized, entry.operations.size());
+    for (size_t i = 0; i < entry.operations.size(); i++) {
+        const Operation& operation = entry.operations[i];
+        writeNumber(serialized, operation.position);
+        writeNumber(serialized, operation.removed.size());
+        writeNumber(serialized, operation.inserted.size());
+        serialized += operation.removed;
+        serialized += operation.inserted;
+    }
+
+    std::string packed;
+    LzCodec::compress(serialized.data(), serialized.size(), packed);
+    if (packed.size() >= entry.rawBytes) return;  // not worth it, stay hot
+
+    entry.packed.swap(packed);
+    entry.packedLength = serialized.size();
+    std::vector<Operation>().swap(entry.operations);
+    entry.cold = true;
+
+    storedBytes = storedBytes - entry.rawBytes + entry.packed.size();
+    coldEntries++;
+    coldRawBytes += entry.rawBytes;
+    coldBytes += entry.packed.size();
+}
+
+bool EditHistory::thaw(Entry& entry) {
+    if (!entry.cold) return true;
+
+    std::string serialized;
+    if (!LzCodec::decompress(entry.packed.data(), entry.packed.size(), serialized, entry.packedLength)) {
+        return false;
+    }
+
+    size_t cursor = 0;
+    size_t count;
+    if (!readNumber(serialized, cursor, count)) return false;
+
+    std::vector<Operation> operations(count);
+    for (size_t i = 0; i < count; i++) {
+        size_t removedLength, insertedLength;
+        if (!readNumber(serialized, cursor, operations[i].position) ||
+            !readNumber(serialized, cursor, removedLength) ||
+            !readNumber(serialized, cursor, insertedLength) ||
+            serialized.size() - cursor < removedLength + insertedLength) {
+            return false;
+        }
+        operations[i].removed.assign(serialized, cursor, removedLength);
+        cursor += removedLength;
+        operations[i].inserted.assign(serialized, cursor, insertedLength);
+        cursor += insertedLength;
+    }
+
+    storedBytes = storedBytes - entry.packed.size() + entry.rawBytes;
+    coldEntries--;
+    coldRawBytes -= entry.rawBytes;
+    coldBytes -= entry.packed.size();
+
+    entry.operations.swap(operations);
+    std::string().swap(entry.packed);
+    entry.cold = false;
+    return true;
+}
+
+// Compress the entry that just left the hot window
+void EditHistory::coolDown() {
+    if (undoEntries.size() > HOT_ENTRIES) {
+        freeze(undoEntries[undoEntries.size() - 1 - HOT_ENTRIES]);
+    }
+}
+
+void EditHistory::enforceBudget() {
+    // The newest entry is always kept, even if it alone exceeds the budget
+    while (storedBytes > budget && undoEntries.size() > 1) {
+        Entry& oldest = undoEntries.front();
+        storedBytes -= storedSize(oldest);
+        if (oldest.cold) {
+            coldEntries--;
+            coldRawBytes -= oldest.rawBytes;
+            coldBytes -= oldest.packed.size();
+        }
+        undoEntries.pop_front();
+        evictedEntries++;
+    }
+}
+
+void EditHistory::clearRedo() {
+    for (size_t i = 0; i < redoEntries.size(); i++) {
+        storedBytes -= storedSize(redoEntries[i]);
+    }
+    redoEntries.clear();
+}
+
+void EditHistory::checkpoint() {
+    if (transactionDepth == 0) entryOpen = false;
+}
+
+void EditHistory::beginTransaction() {
+    if (transactionDepth++ == 0) {
+        entryOpen = false;
+        coalescable = false;
+    }
+}
+
+void EditHistory::commitTransaction() {
+    if (transactionDepth == 0) return;
+    if (--transactionDepth == 0) entryOpen = false;
+}
+
+void EditHistory::recordInsert(size_t position, const char* text, size_t length) {
+    if (!text || length == 0) return;
+
+    if (continuesLastEntry(position, length, true)) entryOpen = true;
+    Entry& entry = currentEntry();
+    std::vector<Operation>& operations = entry.operations;
+
+    // An insert right where the previous operation removed text turns that
+    // operation into a replacement
+    if (!operations.empty()) {
+        Operation& last = operations.back();
+        if (last.position == position && last.inserted.empty() && !last.replacement) {
+            last.inserted.assign(text, length);
+            addBytes(entry, length);
+            return;
+        }
+        if (!last.inserted.empty() && last.position + last.inserted.size() == position) {
+            last.inserted.append(text, length);
+            addBytes(entry, length);
+            return;
+        }
+    }
+
+    operations.push_back(Operation());
+    operations.back().position = position;
+    operations.back().inserted.assign(text, length);
+    addBytes(entry, length);
+}
+
+void EditHistory::recordErase(size_t position, std::string& removed) {
+    if (removed.empty()) return;
+
+    size_t length = removed.size();
+    if (continuesLastEntry(position, length, false)) entryOpen = true;
+    Entry& entry = currentEntry();
+
+    // Deleting forwards from the same position, or backwards up to the
+    // previous erase, extends that erase
+    if (!entry.operations.empty()) {
+        Operation& last = entry.operations.back();
+        if (last.inserted.empty() && !last.replacement) {
+            if (last.position == position) {
+                last.removed += removed;
+                addBytes(entry, length);
+                return;
+            }
+            if (position + length == last.position) {
+                removed += last.removed;
+                last.removed.swap(removed);
+                last.position = position;
+                addBytes(entry, length);
+                return;
+            }
+        }
+    }
+
+    entry.operations.push_back(Operation());
+    entry.operations.back().position = position;
+    entry.operations.back().removed.swap(removed);
+    addBytes(entry, length);
+}
+
+void EditHistory::recordReplace(const PieceTable::Snapshot& before, const PieceTable::Snapshot& after) {
+    Replacement* replacement = new Replacement();
+    replacement->before = before;
+    replacement->after = after;
+
+    Entry& entry = currentEntry();
+    coalescable = false;
+    entry.operations.push_back(Operation());
+    entry.operations.back().position = 0;
+    entry.operations.back().replacement.reset(replacement);
+    entry.hasReplacement = true;
+
+    // The snapshots share their nodes with other versions, but the buffers
+    // of the text that was replaced are kept alive by this entry alone (or,
+    // further back, by the entry that created them, which is charged for
+    // them in turn), so the budget also evicts replacements
+    addBytes(entry, sizeof(Replacement) + before.unsharedBytes(after));
+}
+
+bool EditHistory::undo(PieceTable& table, EditListener* listener) {
+    entryOpen = false;
+    coalescable = false;
+    if (undoEntries.empty()) return false;
+
+    Entry& entry = undoEntries.back();
+    if (!thaw(entry)) return false;
+
+    std::vector<Operation>& operations = entry.operations;
+    for (std::vector<Operation>::reverse_iterator operation = operations.rbegin(); operation != operations.rend();
+         ++operation) {
+        if (operation->replacement) {
+            table.restore(operation->replacement->before);
+            if (listener) listener->restored();
+            continue;
+        }
+        table.erase(operation->position, operation->inserted.size());
+        table.insert(operation->position, operation->removed.data(), operation->removed.size());
+        if (listener) {
+            listener->erased(operation->position, operation->inserted.size());
+            listener->inserted(operation->position, operation->removed.data(), operation->removed.size());
+        }
+    }
+
+    redoEntries.push_back(Entry());
+    std::swap(redoEntries.back(), entry);
+    undoEntries.pop_back();
+    return true;
+}
+
+bool EditHistory::redo(PieceTable& table, EditListener* listener) {
+    entryOpen = false;
+    coalescable = false;
+    if (redoEntries.empty()) return false;
+
+    Entry& entry = redoEntries.back();
+    std::vector<Operation>& operations = entry.operations;
+    for (std::vector<Operation>::iterator operation = operations.begin(); operation != operations.end(); ++operation) {
+        if (operation->replacement) {
+            table.restore(operation->replacement->after);
+            if (listener) listener->restored();
+            continue;
+        }
+        table.erase(operation->position, operation->removed.size());
+        table.insert(operation->position, operation->inserted.data(), operation->inserted.size());
+        if (listener) {
+            listener->erased(operation->position, operation->removed.size());
+            listener->inserted(operation->position, operation->inserted.data(), operation->inserted.size());
+        }
+    }
+
+    undoEntries.push_back(Entry());
+    std::swap(undoEntries.back(), entry);
+    redoEntries.pop_back();
+    coolDown();
+    return true;
+}
+
+void EditHistory::clear() {
+    undoEntries.clear();
+    redoEntries.clear();
+    entryOpen = false;
+    coalescable = false;
+    transactionDepth = 0;
+    storedBytes = 0;
+    coldEntries = 0;
+    coldRawBytes = 0;
+    coldBytes = 0;
+    evictedEntries = 0;
+}
+
+void EditHistory::setBudget(size_t bytes) {
+    budget = bytes;
+    enforceBudget();
+}
+
+void EditHistory::statistics(HistoryStats& stats) const {
+    stats.undoEntries = undoEntries.size();
+    stats.redoEntries = redoEntries.size();
+    stats.compressedEntries = coldEntries;
+    stats.evictedEntries = evictedEntries;
+    stats.storedBytes = storedBytes;
+    stats.compressedRawBytes = coldRawBytes;
+    stats.compressedBytes = coldBytes;
+    stats.budget = budget;
+}
@@ -0,0 +1,129 @@
+#ifndef EDIT_HISTORY_H
+#define EDIT_HISTORY_H
+
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+#include "PieceTable.h"
+#include "TextEditorApi.h"
+
+// Told about every change undo and redo make to the table
+class EditListener {
+public:
+    virtual ~EditListener() {}
+
+    virtual void inserted(size_t position, const char* text, size_t length) = 0;
+    virtual void erased(size_t position, size_t length) = 0;
+    virtual void restored() = 0;   // the whole text was swapped for a snapshot
+};
+
+// Undo/redo as a log of edits instead of copies of the whole text.
+//
+// An entry is the list of operations one command performed. Each operation
+// remembers its position and the bytes it removed and inserted, which is
+// all that is needed to apply it in either direction, so undo and redo cost
+// O(edit size) no matter how large the document is.
+//
+// Depth is unlimited; memory is bounded by a byte budget instead. The most
+// recent entries stay as they are, older ones are packed and LZ-compressed,
+// and the oldest are dropped only once the budget is exceeded.
+//
+// Replacing the whole text is recorded as a pair of piece table snapshots
+// instead, which costs O(1) however large the text is. Such an entry is
+// charged for the buffers of the replaced text, which only it keeps alive,
+// so a run of replacements cannot pin one copy of the text each.
+//
+// Small edits that continue the previous command (typing or appending at a
+// moving cursor, deleting forwards or backwards from the same spot) are
+// merged into its entry, unless merging is turned off, as it is for callers
+// whose every command must undo on its own. A transaction groups everything
+// between begin and commit into one entry and never merges with its
+// neighbours.
+class EditHistory {
+private:
+    struct Replacement {
+        PieceTable::Snapshot before;
+        PieceTable::Snapshot after;
+    };
+
+    struct Operation {
+        size_t position;
+        std::string removed;
+        std::string inserted;
+        std::shared_ptr<const Replacement> replacement;
+    };
+
+    struct Entry {
+        std::vector<Operation> operations;  // empty while the entry is cold
+        std::string packed;                 // compressed operations of a cold entry
+        size_t rawBytes;                    // bytes removed + inserted, or pinned by a replacement
+        size_t packedLength;                // size of the packed form before compression
+        bool cold;
+        bool hasReplacement;                // snapshots can't be packed; stays hot
+
+        Entry() : rawBytes(0), packedLength(0), cold(false), hasReplacement(false) {}
+    };
+
+    static const size_t HOT_ENTRIES = 16;
+    static const size_t COALESCE_BYTES = 4096;   // merged entries stop growing here
+
+    std::deque<Entry> undoEntries;
+    std::vector<Entry> redoEntries;
+    bool entryOpen;
+    bool coalescable;          // the newest entry may still absorb a continuing edit
+    bool coalescing;           // continuing edits are merged at all
+    size_t transactionDepth;
+
+    size_t budget;
+    size_t storedBytes;
+    size_t coldEntries;
+    size_t coldRawBytes;
+    size_t coldBytes;
+    size_t evictedEntries;
+
+    static size_t storedSize(const Entry& entry);
+    Entry& currentEntry();
+    bool continuesLastEntry(size_t position, size_t length, bool insert) const;
+    void addBytes(Entry& entry, size_t bytes);
+    void freeze(Entry& entry);
+    bool thaw(Entry& entry);
+    void coolDown();
+    void enforceBudget();
+    void clearRedo();
+
+public:
+    static const size_t DEFAULT_BUDGET = (size_t)64 << 20;
+
+    explicit EditHistory(size_t budget = DEFAULT_BUDGET);
+
+    // Close the current entry; the next edit starts a new one unless it
+    // continues this one. Ignored inside a transaction.
+    void checkpoint();
+
+    // Whether an edit that continues the closed newest entry is merged into
+    // it (the default) or starts an entry of its own
+    void setCoalescing(bool enabled) { coalescing = enabled; }
+
+    // Everything recorded between the outermost begin and commit becomes one
+    // entry. Transactions nest.
+    void beginTransaction();
+    void commitTransaction();
+
+    void recordInsert(size_t position, const char* text, size_t length);
+    void recordErase(size_t position, std::string& removed);  // takes the string's contents
+    void recordReplace(const PieceTable::Snapshot& before, const PieceTable::Snapshot& after);
+
+    // Apply the inverse (undo) or the original (redo) of one entry
+    bool undo(PieceTable& table, EditListener* listener = nullptr);
+    bool redo(PieceTable& table, EditListener* listener = nullptr);
+
+    void clear();
+    void setBudget(size_t bytes);
+    void statistics(HistoryStats& stats) const;
+    size_t undoDepth() const { return undoEntries.size(); }
+    size_t redoDepth() const { return redoEntries.size(); }
+};
+
+#endif // EDIT_HISTORY_H
@@ -0,0 +1,599 @@
+#include "EditJournal.h"
+#include "PieceTable.h"
+#include "AtomicFileWriter.h"
+#include "MappedFile.h"
+#include "EditorError.h"
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+const char JOURNAL_MAGIC[8] = {'N', 'S', 'E', 'J', 'R', 'N', 'L', '1'};
+const char CHECKPOINT_MAGIC[8] = {'N', 'S', 'E', 'C', 'K', 'P', 'T', '1'};
+const char SOURCE_MAGIC[8] = {'N', 'S', 'E', 'C', 'K', 'P', 'F', '1'};   // checkpoint by file reference
+const size_t HEADER_SIZE = 16;
+
+const char RECORD_INSERT = 'I';
+const char RECORD_ERASE = 'E';
+
+// How long the flusher waits for more records to share one fsync
+const std::chrono::milliseconds GROUP_COMMIT_WINDOW(10);
+const size_t FLUSH_BYTES = 1 << 20;
+
+void writeNumber(std::string& output, size_t value) {
+    while (value >= 0x80) {
+        output.push_back((char)(value | 0x80));
+        value >>= 7;
+    }
+    output.push_back((char)value);
+}
+
+bool readNumber(const std::string& input, size_t& cursor, size_t& value) {
+    value = 0;
+    for (int shift = 0; cursor < input.size() && shift < 64; shift += 7) {
+        unsigned char byte = (unsigned char)input[cursor++];
+        value |= (size_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) return true;
+    }
+    return false;
+}
+
+// FNV-1a, enough to tell a torn or garbled record from a good one
+unsigned int checksum(unsigned int hash, const char* data, size_t length) {
+    for (size_t i = 0; i < length; i++) {
+        hash ^= (unsigned char)data[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+const unsigned int CHECKSUM_SEED = 2166136261u;
+
+void writeHeader(char* header, const char* magic, unsigned long long sequence) {
+    memcpy(header, magic, 8);
+    for (int i = 0; i < 8; i++) {
+        header[8 + i] = (char)((sequence >> (8 * i)) & 0xFF);
+    }
+}
+
+bool readHeader(const std::string& data, const char* magic, unsigned long long& sequence) {
+    if (data.size() < HEADER_SIZE || memcmp(data.data(), magic, 8) != 0) return false;
+
+    sequence = 0;
+    for (int i = 0; i < 8; i++) {
+        sequence |= (unsigned long long)(unsigned char)data[8 + i] << (8 * i);
+    }
+    return true;
+}
+
+bool readWholeFile(const std::string& path, std::string& output) {
+    FILE* file = fopen(path.c_str(), "rb");
+    if (!file) return false;
+
+    output.clear();
+    char block[1 << 16];
+    size_t count;
+    while ((count = fread(block, 1, sizeof(block), file)) > 0) {
+        output.append(block, count);
+    }
+    bool failed = ferror(file) != 0;
+    fclose(file);
+    return !failed;
+}
+
+long modifiedNanoseconds(const struct stat& info) {
+#ifdef __APPLE__
+    return info.st_mtimespec.tv_nsec;
+#else
+    return info.st_mtim.tv_nsec;
+#endif
+}
+
+// What a file reference checkpoint records: size and modification time,
+// then the absolute path
+void encodeSource(std::string& output, const char* path, const struct stat& info) {
+    writeNumber(output, (size_t)info.st_size);
+    writeNumber(output, (size_t)info.st_mtime);
+    writeNumber(output, (size_t)modifiedNanoseconds(info));
+    output += path;
+}
+
+} // namespace
+
+EditJournal::EditJournal()
+    : lockFd(-1), active(false), sequence(0), recordsSinceCheckpoint(0), bytesSinceCheckpoint(0), replaced(false),
+      recoveredSession(false), checkpointQueued(false), checkpointBusy(false), stopping(false), discarding(false),
+      failed(false), fd(-1), journalUsable(true) {
+}
+
+EditJournal::~EditJournal() {
+    close(false);
+}
+
+void EditJournal::reportFailure(const char* what) {
+    std::string message = std::string("Journal error: ") + what + " (" + strerror(errno) +
+                          "). Recent edits may not survive a crash.";
+    if (!failed.exchange(true)) {
+        {
+            std::lock_guard<std::mutex> lock(failureMutex);
+            failureMessage = message;
+        }
+        setEditorError(message);
+    }
+}
+
+bool EditJournal::failure(std::string& message) {
+    if (!failed) return false;
+    std::lock_guard<std::mutex> lock(failureMutex);
+    message = failureMessage;
+    return true;
+}
+
+// The lock has a file of its own: the journal and the checkpoint are
+// replaced by rename, which would leave a lock held on them behind
+bool EditJournal::lock() {
+    for (;;) {
+        lockFd = ::open(lockPath.c_str(), O_RDWR | O_CREAT, 0666);
+        if (lockFd < 0) {
+            reportFailure("cannot open the journal lock");
+            return false;
+        }
+        if (flock(lockFd, LOCK_EX | LOCK_NB) != 0) {
+            if (errno == EWOULDBLOCK) {
+                setEditorError("Journal " + journalPath + " is in use by another instance.");
+            } else {
+                reportFailure("cannot lock the journal");
+            }
+            ::close(lockFd);
+            lockFd = -1;
+            return false;
+        }
+
+        // A clean exit removes the lock file while holding the lock; if that
+        // happened between our open and flock, this lock guards nothing
+        struct stat locked;
+        struct stat current;
+        if (fstat(lockFd, &locked) == 0 && stat(lockPath.c_str(), &current) == 0 &&
+            locked.st_dev == current.st_dev && locked.st_ino == current.st_ino) {
+            return true;
+        }
+        ::close(lockFd);
+        lockFd = -1;
+    }
+}
+
+bool EditJournal::open(const std::string& path, PieceTable& table, size_t& replayed) {
+    replayed = 0;
+    recoveredSession = false;
+    if (fd >= 0 || lockFd >= 0) return false;
+
+    journalPath = path;
+    checkpointPath = path + ".checkpoint";
+    lockPath = path + ".lock";
+    if (!lock()) return false;
+
+    std::string journal;
+    unsigned long long journalSequence = 0;
+    bool dirty = readWholeFile(journalPath, journal) && readHeader(journal, JOURNAL_MAGIC, journalSequence);
+
+    if (dirty) {
+        std::string content;
+        unsigned long long checkpointSequence = 0;
+        bool isSource = false;
+        bool haveCheckpoint = readCheckpoint(checkpointSequence, content, isSource);
+
+        if (haveCheckpoint && checkpointSequence == journalSequence + 1) {
+            // Died between writing a checkpoint and restarting the journal:
+            // the checkpoint already holds every journaled edit
+            dirty = restoreCheckpoint(content, isSource, table);
+            if (dirty) {
+                sequence = checkpointSequence;
+                if (!startJournal(sequence)) return false;
+            }
+        } else if (haveCheckpoint ? checkpointSequence == journalSequence : journalSequence == 0) {
+            if (haveCheckpoint) {
+                dirty = restoreCheckpoint(content, isSource, table);
+            } else {
+                table.reset(nullptr, 0);
+            }
+
+            if (dirty) {
+                size_t validLength;
+                replayed = replay(journal, table, validLength);
+                sequence = journalSequence;
+
+                // Drop a torn tail so new records follow the last good one
+                if (::truncate(journalPath.c_str(), (off_t)validLength) != 0) {
+                    reportFailure("cannot truncate the journal");
+                    return false;
+                }
+            }
+        } else {
+            setEditorError("Journal " + journalPath + " does not match its checkpoint; starting a new session.");
+            dirty = false;
+        }
+    }
+
+    if (!dirty) {
+        sequence = 0;
+        unlink(checkpointPath.c_str());
+        if (!startJournal(sequence)) return false;
+    }
+
+    if (fd < 0) {
+        fd = ::open(journalPath.c_str(), O_WRONLY | O_APPEND);
+        if (fd < 0) {
+            reportFailure("cannot open the journal");
+            return false;
+        }
+    }
+
+    recoveredSession = dirty;
+    recordsSinceCheckpoint = replayed;
+    bytesSinceCheckpoint = journal.size() > HEADER_SIZE ? journal.size() - HEADER_SIZE : 0;
+    replaced = false;
+    stopping = false;
+    discarding = false;
+    journalUsable = true;
+    active = true;
+    flusher = std::thread(&EditJournal::flushLoop, this);
+
+    // A new session starts from the text already there
+    if (!dirty && table.length() > 0) {
+        checkpoint(table);
+    }
+    return true;
+}
+
+void EditJournal::close(bool discard) {
+    if (flusher.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(pendingMutex);
+            stopping = true;
+            discarding = discard;
+        }
+        wake.notify_all();
+        flusher.join();
+    }
+    active = false;
+    checkpointSource = PieceTable::Snapshot();
+    checkpointBusy = false;
+
+    if (fd >= 0) {
+        ::close(fd);
+        fd = -1;
+
+        // Journal first: a checkpoint without a journal is just a leftover
+        if (discard) {
+            unlink(journalPath.c_str());
+            unlink(checkpointPath.c_str());
+        }
+    }
+
+    if (lockFd >= 0) {
+        if (discard) {
+            unlink(lockPath.c_str());
+        }
+        ::close(lockFd);
+        lockFd = -1;
+    }
+}
+
+// Atomically replace the journal with an empty one for newSequence
+bool EditJournal::startJournal(unsigned long long newSequence) {
+    char header[HEADER_SIZE];
+    writeHeader(header, JOURNAL_MAGIC, newSequence);
+
+    AtomicFileWriter writer(journalPath);
+    if (!writer.open() || !writer.write(header, sizeof(header)) || !writer.commit()) {
+        reportFailure("cannot restart the journal");
+        return false;
+    }
+
+    // Reopen: the old descriptor still refers to the replaced file
+    int newFd = ::open(journalPath.c_str(), O_WRONLY | O_APPEND);
+    if (newFd < 0) {
+        reportFailure("cannot open the journal");
+        return false;
+    }
+    if (fd >= 0) {
+        ::close(fd);
+    }
+    fd = newFd;
+    return true;
+}
+
+void EditJournal::writeCheckpointJob(const CheckpointJob& job) {
+    // Records from before the snapshot still belong in the old journal: a
+    // crash before the new checkpoint is in place recovers from that one
+    appendToJournal(job.recordsBefore);
+
+    bool isSource = !job.source.empty();
+    char header[HEADER_SIZE];
+    writeHeader(header, isSource ? SOURCE_MAGIC : CHECKPOINT_MAGIC, job.sequence);
+
+    AtomicFileWriter writer(checkpointPath);
+    bool written = writer.open() && writer.write(header, sizeof(header)) &&
+                   (isSource ? writer.write(job.source.data(), job.source.size()) : writer.write(job.segments)) &&
+                   writer.commit();
+    if (!written) {
+        reportFailure("cannot write a checkpoint");
+    }
+
+    // Later records describe edits to the checkpointed text; without it
+    // they have nowhere valid to go until the next checkpoint succeeds
+    journalUsable = written && startJournal(job.sequence);
+}
+
+bool EditJournal::readCheckpoint(unsigned long long& checkpointSequence, std::string& content, bool& isSource) const {
+    if (!readWholeFile(checkpointPath, content)) return false;
+
+    isSource = readHeader(content, SOURCE_MAGIC, checkpointSequence);
+    if (!isSource && !readHeader(content, CHECKPOINT_MAGIC, checkpointSequence)) return false;
+    content.erase(0, HEADER_SIZE);
+    return true;
+}
+
+// Load a checkpoint into table; a file reference only if the file is still
+// the one that was recorded
+bool EditJournal::restoreCheckpoint(std::string& content, bool isSource, PieceTable& table) const {
+    if (!isSource) {
+        table.reset(content);
+        return true;
+    }
+
+    size_t cursor = 0;
+    size_t size, seconds, nanoseconds;
+    struct stat info;
+    if (!readNumber(content, cursor, size) || !readNumber(content, cursor, seconds) ||
+        !readNumber(content, cursor, nanoseconds)) {
+        setEditorError("Journal checkpoint " + checkpointPath + " is damaged; starting a new session.");
+        return false;
+    }
+    std::string path = content.substr(cursor);
+
+    if (stat(path.c_str(), &info) != 0 || (size_t)info.st_size != size || (size_t)info.st_mtime != seconds ||
+        (size_t)modifiedNanoseconds(info) != nanoseconds) {
+        setEditorError(path + " changed after the last session journaled edits to it; starting a new session.");
+        return false;
+    }
+
+    if (size == 0) {
+        table.reset(nullptr, 0);
+        return true;
+    }
+    MappedFile* mapping = new MappedFile();
+    if (!mapping->open(path.c_str()) || mapping->size() != size) {
+        delete mapping;
+        setEditorError("Cannot read " + path + " to recover the last session; starting a new session.");
+        return false;
+    }
+    table.reset(mapping);
+    return true;
+}
+
+size_t EditJournal::replay(const std::string& journal, PieceTable& table, size_t& validLength) const {
+    size_t applied = 0;
+    size_t cursor = HEADER_SIZE;
+    validLength = HEADER_SIZE;
+
+    while (cursor < journal.size()) {
+        size_t start = cursor;
+        char type = journal[cursor++];
+        size_t position, length;
+        if ((type != RECORD_INSERT && type != RECORD_ERASE) ||
+            !readNumber(journal, cursor, position) || !readNumber(journal, cursor, length)) {
+            break;
+        }
+
+        size_t payload = type == RECORD_INSERT ? length : 0;
+        if (journal.size() - cursor < payload + 4) break;
+        cursor += payload;
+
+        unsigned int stored = 0;
+        for (int i = 0; i < 4; i++) {
+            stored |= (unsigned int)(unsigned char)journal[cursor + i] << (8 * i);
+        }
+        if (checksum(CHECKSUM_SEED, journal.data() + start, cursor - start) != stored) break;
+        cursor += 4;
+
+        if (position > table.length()) break;
+        if (type == RECORD_INSERT) {
+            table.insert(position, journal.data() + cursor - 4 - payload, payload);
+        } else {
+            table.erase(position, length);
+        }
+
+        applied++;
+        validLength = cursor;
+    }
+
+    return applied;
+}
+
+void EditJournal::appendRecord(char type, size_t position, const char* text, size_t length) {
+    std::string header;
+    header.push_back(type);
+    writeNumber(header, position);
+    writeNumber(header, length);
+
+    size_t payload = type == RECORD_INSERT ? length : 0;
+    unsigned int hash = checksum(checksum(CHECKSUM_SEED, header.data(), header.size()), text, payload);
+    char trailer[4];
+    for (int i = 0; i < 4; i++) {
+        trailer[i] = (char)((hash >> (8 * i)) & 0xFF);
+    }
+
+    bool wakeFlusher;
+    {
+        std::lock_guard<std::mutex> lock(pendingMutex);
+        wakeFlusher = pending.empty();
+        pending += header;
+        if (payload > 0) {
+            pending.append(text, payload);
+        }
+        pending.append(trailer, sizeof(trailer));
+        wakeFlusher = wakeFlusher || pending.size() >= FLUSH_BYTES;
+    }
+    if (wakeFlusher) {
+        wake.notify_one();
+    }
+
+    recordsSinceCheckpoint++;
+    bytesSinceCheckpoint += header.size() + payload + sizeof(trailer);
+}
+
+void EditJournal::flushLoop() {
+    std::unique_lock<std::mutex> lock(pendingMutex);
+
+    for (;;) {
+        wake.wait(lock, [this] { return stopping || checkpointQueued || !pending.empty(); });
+        if (discarding) break;
+
+        // A queued checkpoint goes first: the pending records follow it
+        if (checkpointQueued) {
+            CheckpointJob job;
+            std::swap(job, queuedCheckpoint);
+            checkpointQueued = false;
+            lock.unlock();
+
+            writeCheckpointJob(job);
+
+            lock.lock();
+            checkpointBusy = false;
+            checkpointDone.notify_all();
+            continue;
+        }
+        if (pending.empty()) break;
+
+        // Group commit: let records that arrive meanwhile share this fsync
+        if (!stopping) {
+            wake.wait_for(lock, GROUP_COMMIT_WINDOW,
+                          [this] { return stopping || checkpointQueued || pending.size() >= FLUSH_BYTES; });
+            if (checkpointQueued) continue;
+        }
+
+        std::string batch;
+        batch.swap(pending);
+        lock.unlock();
+
+        appendToJournal(batch);
+
+        lock.lock();
+    }
+}
+
+void EditJournal::appendToJournal(const std::string& records) {
+    if (records.empty() || fd < 0 || !journalUsable) return;
+
+    size_t written = 0;
+    while (written < records.size()) {
+        ssize_t count = ::write(fd, records.data() + written, records.size() - written);
+        if (count < 0) {
+            if (errno == EINTR) continue;
+            reportFailure("cannot append to the journal");
+            return;
+        }
+        written += (size_t)count;
+    }
+    if (fsync(fd) != 0) {
+        reportFailure("cannot sync the journal");
+    }
+}
+
+void EditJournal::waitForCheckpoint() {
+    if (checkpointBusy) {
+        std::unique_lock<std::mutex> lock(pendingMutex);
+        checkpointDone.wait(lock, [this] { return !checkpointBusy; });
+    }
+    checkpointSource = PieceTable::Snapshot();
+}
+
+// Records appended from now on belong to the journal that follows job
+void EditJournal::queueCheckpoint(CheckpointJob& job) {
+    {
+        std::lock_guard<std::mutex> lock(pendingMutex);
+        job.sequence = ++sequence;
+        job.recordsBefore.swap(pending);
+        std::swap(queuedCheckpoint, job);
+        checkpointQueued = true;
+        checkpointBusy = true;
+    }
+    wake.notify_one();
+
+    recordsSinceCheckpoint = 0;
+    bytesSinceCheckpoint = 0;
+    replaced = false;
+}
+
+bool EditJournal::checkpoint(const PieceTable& table) {
+    if (!active) return false;
+    waitForCheckpoint();
+
+    // The flusher reads the runs while editing goes on; the snapshot keeps
+    // the buffers they point into alive until it is done
+    CheckpointJob job;
+    checkpointSource = table.snapshot();
+    checkpointSource.detachedSegments(job.segments, job.copies);
+    queueCheckpoint(job);
+    return true;
+}
+
+bool EditJournal::checkpointFile(const std::string& path, const PieceTable& table) {
+    if (!active) return false;
+
+    // Recovery looks the file up again, maybe from another directory
+    char* resolved = realpath(path.c_str(), nullptr);
+    struct stat info;
+    bool usable = resolved && stat(resolved, &info) == 0 && S_ISREG(info.st_mode) &&
+                  (size_t)info.st_size == table.length();
+    if (!usable) {
+        free(resolved);
+        return checkpoint(table);
+    }
+
+    CheckpointJob job;
+    encodeSource(job.source, resolved, info);
+    free(resolved);
+
+    waitForCheckpoint();
+    queueCheckpoint(job);
+    return true;
+}
+
+bool EditJournal::checkpointDue(size_t textLength) {
+    if (!active) return false;
+    if (replaced) return true;
+
+    // Let go of the last checkpoint's text once it is written
+    if (checkpointBusy) return false;
+    checkpointSource = PieceTable::Snapshot();
+
+    return (recordsSinceCheckpoint >= CHECKPOINT_RECORDS || bytesSinceCheckpoint >= CHECKPOINT_BYTES) &&
+           bytesSinceCheckpoint >= textLength / 2;
+}
+
+// Until the checkpoint that follows a replacement, records would describe
+// edits to a text the journal does not have, so none are written
+
+void EditJournal::inserted(size_t position, const char* text, size_t length) {
+    if (!active || replaced || length == 0) return;
+    appendRecord(RECORD_INSERT, position, text, length);
+}
+
+void EditJournal::erased(size_t position, size_t length) {
+    if (!active || replaced || length == 0) return;
+    appendRecord(RECORD_ERASE, position, nullptr, length);
+}
+
+void EditJournal::restored() {
+    replaced = true;
+}
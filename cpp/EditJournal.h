@@ -0,0 +1,139 @@
+#ifndef EDIT_JOURNAL_H
+#define EDIT_JOURNAL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "EditHistory.h"
+#include "PieceTable.h"
+
+// Write-ahead journal of edits for crash recovery.
+//
+// Edits are appended as checksummed records to an in-memory batch that a
+// background thread writes and fsyncs in groups, so the editing thread never
+// waits on the disk. Every so often (and whenever the whole text is replaced)
+// the journal starts over from a checkpoint of the text, which bounds both
+// the journal size and the replay time. The same thread writes checkpoints,
+// from a snapshot taken when one is due; a text that is exactly a file's
+// contents (just loaded or saved) is checkpointed as a reference to the file,
+// by path, size and modification time, instead of a copy.
+//
+// Files: <path> holds a header with the checkpoint sequence number and the
+// records since that checkpoint; <path>.checkpoint holds the same sequence
+// number and the text or file reference. Both are replaced atomically. A
+// journal that is still there at startup means the previous session did not
+// exit cleanly.
+//
+// A session holds an exclusive flock on <path>.lock for as long as it
+// journals, so a second editor on the same path neither replays the live
+// session's edits nor removes its files on exit; it runs without a journal.
+class EditJournal : public EditListener {
+private:
+    typedef std::pair<const char*, size_t> Segment;
+
+    // A checkpoint handed to the flusher: the records still due in the
+    // journal it replaces, then the text as detached runs, or the encoded
+    // reference to the file that holds it
+    struct CheckpointJob {
+        unsigned long long sequence;
+        std::string recordsBefore;
+        std::vector<Segment> segments;
+        std::vector<char> copies;
+        std::string source;
+    };
+
+    std::string journalPath;
+    std::string checkpointPath;
+    std::string lockPath;
+    int lockFd;
+
+    // Editing thread only
+    bool active;
+    unsigned long long sequence;
+    size_t recordsSinceCheckpoint;
+    size_t bytesSinceCheckpoint;
+    bool replaced;
+    bool recoveredSession;
+    PieceTable::Snapshot checkpointSource;   // keeps a queued checkpoint's runs alive
+
+    // Shared with the flusher thread
+    std::mutex pendingMutex;
+    std::condition_variable wake;
+    std::condition_variable checkpointDone;
+    std::string pending;
+    CheckpointJob queuedCheckpoint;
+    bool checkpointQueued;
+    std::atomic<bool> checkpointBusy;   // queued or being written
+    bool stopping;
+    bool discarding;
+    std::atomic<bool> failed;   // set by either thread, reported once
+    std::mutex failureMutex;
+    std::string failureMessage;   // the first failure
+
+    // Flusher thread only, once it runs
+    int fd;
+    bool journalUsable;   // false after a failed checkpoint until the next one
+
+    std::thread flusher;
+
+    bool lock();
+    void appendRecord(char type, size_t position, const char* text, size_t length);
+    void flushLoop();
+    void appendToJournal(const std::string& records);
+    void writeCheckpointJob(const CheckpointJob& job);
+    void queueCheckpoint(CheckpointJob& job);
+    void waitForCheckpoint();
+    bool startJournal(unsigned long long newSequence);
+    bool readCheckpoint(unsigned long long& checkpointSequence, std::string& content, bool& isSource) const;
+    bool restoreCheckpoint(std::string& content, bool isSource, PieceTable& table) const;
+    size_t replay(const std::string& journal, PieceTable& table, size_t& validLength) const;
+    void reportFailure(const char* what);
+
+public:
+    static const size_t CHECKPOINT_RECORDS = 8192;
+    static const size_t CHECKPOINT_BYTES = (size_t)16 << 20;
+
+    EditJournal();
+    ~EditJournal();   // flushes but keeps the files, as after a crash
+
+    // Start journaling to path. If it holds an unfinished session, that text
+    // is rebuilt into table first and replayed is set to the edits re-applied.
+    // Fails if another editor is journaling to path.
+    bool open(const std::string& path, PieceTable& table, size_t& replayed);
+    bool recovered() const { return recoveredSession; }
+
+    // True once writing the journal or a checkpoint has failed, on either
+    // thread; message is set to the first failure
+    bool failure(std::string& message);
+
+    // Clean shutdown: flush, then remove the files if discard is set
+    void close(bool discard);
+
+    // Queue a checkpoint of the text and restart the journal after it. Only
+    // one is in flight at a time; a second waits for the first. One is due
+    // after a whole text replacement, or once the journal outgrows both the
+    // record limits and the text itself, which keeps checkpoint writes
+    // amortized O(1).
+    bool checkpoint(const PieceTable& table);
+    bool checkpointDue(size_t textLength);
+
+    // The text is now exactly the contents of path: checkpoint a reference
+    // to the file instead of the text, if the file can be found again
+    bool checkpointFile(const std::string& path, const PieceTable& table);
+
+    // EditListener: every change made to the table
+    void inserted(size_t position, const char* text, size_t length);
+    void erased(size_t position, size_t length);
+    void restored();
+
+private:
+    EditJournal(const EditJournal&);
+    EditJournal& operator=(const EditJournal&);
+};
+
+#endif // EDIT_JOURNAL_H
@@ -0,0 +1,380 @@
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "AtomicFileWriter.h"
+#include "../caesar/CaesarCipher.h"
+#include "../caesar/CipherPipeline.h"
+#include "EditorError.h"
+#include "TextEditorApi.h"
+
+// Headless editor API (libtexteditor): the editing commands of the menu
+// with explicit arguments instead of prompts. Nothing here reads stdin or
+// prints; every call reports an EditorStatus and every edit is one undo
+// step, as editorCreate turns off the merging of continued edits. The
+// lower-level buffer* bridges stay available next to it.
+
+static const size_t INITIAL_BUFFER_SIZE = 1024;
+static const size_t ENCRYPT_BLOCK_SIZE = 1 << 20;
+
+static thread_local std::string lastError;
+
+void setEditorError(const std::string& message) {
+    lastError = message;
+}
+
+void clearEditorError() {
+    lastError.clear();
+}
+
+extern "C" const char* editorLastError(void) {
+    return lastError.c_str();
+}
+
+// Loaded on first use, so linking the library costs nothing until then
+static CaesarCipher& cipher() {
+    static CaesarCipher instance;
+    return instance;
+}
+
+// Whether the cipher can be used, with the reason it could not be loaded
+// as the error if not
+static bool cipherReady() {
+    if (cipher().isReady()) return true;
+    setEditorError(cipher().loadError());
+    return false;
+}
+
+static int resolve(TextBuffer* buffer, size_t line, size_t column, size_t& offset) {
+    return bufferLineToOffset(buffer, line, column, &offset) == 0 ? EDITOR_OK : EDITOR_ERROR_POSITION;
+}
+
+extern "C" void resizeBufferIfNeeded(TextBuffer* buffer, size_t additionalSpace) {
+    if (buffer->used + additionalSpace + 1 > buffer->size) {
+        size_t newSize = buffer->size * 2;
+        if (newSize < buffer->used + additionalSpace + 1) {
+            newSize = buffer->used + additionalSpace + 1 + INITIAL_BUFFER_SIZE;
+        }
+
+        char* newBuffer = (char*)realloc(buffer->content, newSize);
+        if (newBuffer == NULL) return;   // callers check buffer->size
+
+        buffer->content = newBuffer;
+        buffer->size = newSize;
+    }
+}
+
+extern "C" int editorCreate(TextBuffer* buffer) {
+    if (!buffer) return EDITOR_ERROR_ARGUMENT;
+
+    buffer->content = (char*)malloc(INITIAL_BUFFER_SIZE);
+    if (!buffer->content) return EDITOR_ERROR_MEMORY;
+
+    buffer->size = INITIAL_BUFFER_SIZE;
+    buffer->used = 0;
+    buffer->content[0] = '\0';
+    buffer->storage = NULL;
+    buffer->contentStale = 0;
+
+    if (initStorage(buffer) != 0) {
+        free(buffer->content);
+        buffer->content = NULL;
+        return EDITOR_ERROR_MEMORY;
+    }
+    bufferSetCoalescing(buffer, 0);
+    return EDITOR_OK;
+}
+
+extern "C" void editorDestroy(TextBuffer* buffer) {
+    if (!buffer) return;
+
+    // Reaching here is a clean shutdown, so the crash journal is not needed
+    bufferCloseJournal(buffer, 1);
+    bufferDisableHistory(buffer);
+    freeStorage(buffer);
+    free(buffer->content);
+    buffer->content = NULL;
+    buffer->size = 0;
+    buffer->used = 0;
+}
+
+extern "C" int editorText(TextBuffer* buffer, const char** text, size_t* length) {
+    if (!buffer || !text) return EDITOR_ERROR_ARGUMENT;
+
+    flattenBuffer(buffer);
+    if (buffer->contentStale) return EDITOR_ERROR_MEMORY;
+
+    *text = buffer->content;
+    if (length) *length = buffer->used;
+    return EDITOR_OK;
+}
+
+extern "C" int editorAppend(TextBuffer* buffer, const char* text, size_t length) {
+    if (!buffer || (!text && length > 0)) return EDITOR_ERROR_ARGUMENT;
+
+    bufferCheckpoint(buffer);
+    return bufferAppend(buffer, text, length) == 0 ? EDITOR_OK : EDITOR_ERROR_MEMORY;
+}
+
+extern "C" int editorInsert(TextBuffer* buffer, size_t line, size_t column, const char* text, size_t length) {
+    if (!buffer || (!text && length > 0)) return EDITOR_ERROR_ARGUMENT;
+
+    size_t offset;
+    int status = resolve(buffer, line, column, offset);
+    if (status != EDITOR_OK) return status;
+
+    bufferCheckpoint(buffer);
+    return bufferInsert(buffer, offset, text, length) == 0 ? EDITOR_OK : EDITOR_ERROR_MEMORY;
+}
+
+extern "C" int editorDelete(TextBuffer* buffer, size_t line, size_t column, size_t count, size_t* deleted) {
+    if (!buffer) return EDITOR_ERROR_ARGUMENT;
+
+    size_t offset;
+    int status = resolve(buffer, line, column, offset);
+    if (status != EDITOR_OK) return status;
+    if (offset >= buffer->used) return EDITOR_ERROR_POSITION;
+
+    if (count > buffer->used - offset) count = buffer->used - offset;
+    bufferCheckpoint(buffer);
+    if (bufferErase(buffer, offset, count) != 0) return EDITOR_ERROR_MEMORY;
+
+    if (deleted) *deleted = count;
+    return EDITOR_OK;
+}
+
+extern "C" int editorReplace(TextBuffer* buffer, size_t line, size_t column, const char* text, size_t length) {
+    if (!buffer || (!text && length > 0)) return EDITOR_ERROR_ARGUMENT;
+
+    size_t offset;
+    int status = resolve(buffer, line, column, offset);
+    if (status != EDITOR_OK) return status;
+    if (offset >= buffer->used) return EDITOR_ERROR_POSITION;
+
+    BufferEdit edit;
+    edit.offset = offset;
+    edit.deleteLength = length < buffer->used - offset ? length : buffer->used - offset;
+    edit.text = text;
+    edit.length = length;
+
+    bufferCheckpoint(buffer);
+    return bufferApplyEdits(buffer, &edit, 1) == 0 ? EDITOR_OK : EDITOR_ERROR_MEMORY;
+}
+
+extern "C" int editorCopy(TextBuffer* buffer, size_t line, size_t column, size_t count, char name, size_t* copied) {
+    if (!buffer) return EDITOR_ERROR_ARGUMENT;
+
+    size_t offset;
+    int status = resolve(buffer, line, column, offset);
+    if (status != EDITOR_OK) return status;
+
+    if (count > buffer->used - offset) count = buffer->used - offset;
+    if (count == 0) return EDITOR_NOTHING;
+    if (bufferCopyToRegister(buffer, offset, count, name) != 0) return EDITOR_ERROR_ARGUMENT;
+
+    if (copied) *copied = count;
+    return EDITOR_OK;
+}
+
+extern "C" int editorCut(TextBuffer* buffer, size_t line, size_t column, size_t count, char name, size_t* cut) {
+    size_t copied = 0;
+    int status = editorCopy(buffer, line, column, count, name, &copied);
+    if (status != EDITOR_OK) return status;
+
+    size_t offset;
+    resolve(buffer, line, column, offset);
+    bufferCheckpoint(buffer);
+    if (bufferErase(buffer, offset, copied) != 0) return EDITOR_ERROR_MEMORY;
+
+    if (cut) *cut = copied;
+    return EDITOR_OK;
+}
+
+extern "C" int editorPaste(TextBuffer* buffer, size_t line, size_t column, char name, size_t* pasted) {
+    if (!buffer) return EDITOR_ERROR_ARGUMENT;
+
+    size_t offset;
+    int status = resolve(buffer, line, column, offset);
+    if (status != EDITOR_OK) return status;
+
+    bufferCheckpoint(buffer);
+    status = bufferPasteRegister(buffer, offset, name, pasted);
+    if (status > 0) return EDITOR_NOTHING;
+    return status == 0 ? EDITOR_OK : EDITOR_ERROR_MEMORY;
+}
+
+extern "C" int editorSearch(TextBuffer* buffer, const char* pattern, size_t length, SearchResults* results) {
+    if (!buffer || !pattern || length == 0 || !results) return EDITOR_ERROR_ARGUMENT;
+    return searchBuffer(buffer, pattern, length, results) == 0 ? EDITOR_OK : EDITOR_ERROR_MEMORY;
+}
+
+extern "C" int editorSearchRegex(TextBuffer* buffer, const char* pattern, size_t length, SearchResults* results) {
+    if (!buffer || !pattern || length == 0 || !results) return EDITOR_ERROR_ARGUMENT;
+
+    // The only way a regex search fails is a pattern that doesn't compile
+    return searchBufferRegex(buffer, pattern, length, results) == 0 ? EDITOR_OK : EDITOR_ERROR_ARGUMENT;
+}
+
+extern "C" int editorUndo(TextBuffer* buffer) {
+    int status = bufferUndo(buffer);
+    if (status > 0) return EDITOR_NOTHING;
+    return status == 0 ? EDITOR_OK : EDITOR_ERROR_ARGUMENT;
+}
+
+extern "C" int editorRedo(TextBuffer* buffer) {
+    int status = bufferRedo(buffer);
+    if (status > 0) return EDITOR_NOTHING;
+    return status == 0 ? EDITOR_OK : EDITOR_ERROR_ARGUMENT;
+}
+
+extern "C" int editorLoad(TextBuffer* buffer, const char* path) {
+    if (!buffer || !path) return EDITOR_ERROR_ARGUMENT;
+
+    bufferCheckpoint(buffer);
+    return bufferLoadFile(buffer, path) == 0 ? EDITOR_OK : EDITOR_ERROR_IO;
+}
+
+extern "C" int editorSave(TextBuffer* buffer, const char* path, size_t* bytesWritten, double* seconds) {
+    if (!buffer || !path) return EDITOR_ERROR_ARGUMENT;
+    return bufferSaveFile(buffer, path, bytesWritten, seconds) == 0 ? EDITOR_OK : EDITOR_ERROR_IO;
+}
+
+extern "C" int editorCipherReady(void) {
+    return cipherReady() ? 1 : 0;
+}
+
+struct CipherJob {
+    int key;
+    bool encrypting;
+};
+
+static int applyCipher(const char* input, char* output, size_t length, void* context) {
+    const CipherJob* job = static_cast<const CipherJob*>(context);
+    bool done = job->encrypting ? cipher().encrypt(input, output, length, job->key)
+                                : cipher().decrypt(input, output, length, job->key);
+    return done ? 0 : -1;
+}
+
+// Replace the buffer's text with its encryption or decryption. The cipher
+// writes straight into the storage of the new version, so beyond that one
+// buffer nothing is allocated or copied, and content (possibly a read-only
+// mapping of the loaded file) is only read.
+static int transformBuffer(TextBuffer* buffer, int key, bool encrypting) {
+    if (!buffer) return EDITOR_ERROR_ARGUMENT;
+    if (!cipherReady()) return EDITOR_ERROR_CIPHER;
+    if (buffer->used == 0) return EDITOR_NOTHING;
+
+    CipherJob job = {key, encrypting};
+    bufferCheckpoint(buffer);
+    return bufferTransform(buffer, applyCipher, &job) == 0 ? EDITOR_OK : EDITOR_ERROR_CIPHER;
+}
+
+extern "C" int editorEncrypt(TextBuffer* buffer, int key) {
+    return transformBuffer(buffer, key, true);
+}
+
+extern "C" int editorDecrypt(TextBuffer* buffer, int key) {
+    return transformBuffer(buffer, key, false);
+}
+
+extern "C" int editorEncryptFile(const char* inputPath, const char* outputPath, int key) {
+    if (!inputPath || !outputPath) return EDITOR_ERROR_ARGUMENT;
+    if (!cipherReady()) return EDITOR_ERROR_CIPHER;
+    return cipher().encryptFile(inputPath, outputPath, key) ? EDITOR_OK : EDITOR_ERROR_IO;
+}
+
+extern "C" int editorDecryptFile(const char* inputPath, const char* outputPath, int key) {
+    if (!inputPath || !outputPath) return EDITOR_ERROR_ARGUMENT;
+    if (!cipherReady()) return EDITOR_ERROR_CIPHER;
+    return cipher().decryptFile(inputPath, outputPath, key) ? EDITOR_OK : EDITOR_ERROR_IO;
+}
+
+extern "C" int editorEncryptFileParallel(const char* inputPath, const char* outputPath, int key,
+                                         size_t threadCount) {
+    if (!inputPath || !outputPath) return EDITOR_ERROR_ARGUMENT;
+    if (!cipherReady()) return EDITOR_ERROR_CIPHER;
+    return cipher().encryptFileParallel(inputPath, outputPath, key, threadCount) ? EDITOR_OK : EDITOR_ERROR_IO;
+}
+
+extern "C" int editorDecryptFileParallel(const char* inputPath, const char* outputPath, int key,
+                                         size_t threadCount) {
+    if (!inputPath || !outputPath) return EDITOR_ERROR_ARGUMENT;
+    if (!cipherReady()) return EDITOR_ERROR_CIPHER;
+    return cipher().decryptFileParallel(inputPath, outputPath, key, threadCount) ? EDITOR_OK : EDITOR_ERROR_IO;
+}
+
+extern "C" int editorEncryptManifest(const char* manifestPath, size_t ioThreads, EncryptBatchStats* stats) {
+    if (!manifestPath || !stats) return EDITOR_ERROR_ARGUMENT;
+    clearEditorError();
+    if (!cipherReady()) return EDITOR_ERROR_CIPHER;
+
+    std::vector<CipherPipeline::Job> jobs;
+    size_t invalid = 0;
+    std::string problems;
+    if (!CipherPipeline::readManifest(manifestPath, jobs, invalid, problems)) {
+        setEditorError("Could not read manifest " + std::string(manifestPath));
+        return EDITOR_ERROR_IO;
+    }
+
+    CipherPipeline pipeline(cipher(), ioThreads);
+    pipeline.run(jobs, *stats);
+    stats->failed += invalid;
+    setEditorError(problems + pipeline.problems());
+    return EDITOR_OK;
+}
+
+struct EncryptedWrite {
+    AtomicFileWriter* writer;
+    std::vector<char>* block;
+    int key;
+};
+
+static int writeEncrypted(const char* text, size_t length, void* context) {
+    EncryptedWrite* write = static_cast<EncryptedWrite*>(context);
+    std::vector<char>& block = *write->block;
+    for (size_t offset = 0; offset < length; offset += block.size()) {
+        size_t count = length - offset < block.size() ? length - offset : block.size();
+        cipher().encrypt(text + offset, block.data(), count, write->key);
+        if (!write->writer->write(block.data(), count)) return -1;
+    }
+    return 0;
+}
+
+extern "C" int editorSaveEncrypted(TextBuffer* buffer, const char* path, int key) {
+    if (!buffer || !path) return EDITOR_ERROR_ARGUMENT;
+    if (!cipherReady()) return EDITOR_ERROR_CIPHER;
+    if (buffer->used == 0) return EDITOR_NOTHING;
+
+    // Encrypt the stored runs through one block-sized buffer instead of a
+    // copy of the text
+    std::vector<char> block(buffer->used < ENCRYPT_BLOCK_SIZE ? buffer->used : ENCRYPT_BLOCK_SIZE);
+
+    AtomicFileWriter writer(path);
+    if (!writer.open()) return EDITOR_ERROR_IO;
+    EncryptedWrite write = { &writer, &block, key };
+    if (bufferVisitText(buffer, writeEncrypted, &write) != 0) return EDITOR_ERROR_IO;
+    return writer.commit() ? EDITOR_OK : EDITOR_ERROR_IO;
+}
+
+extern "C" int editorLoadEncrypted(TextBuffer* buffer, const char* path, int key) {
+    if (!buffer || !path) return EDITOR_ERROR_ARGUMENT;
+    if (!cipherReady()) return EDITOR_ERROR_CIPHER;
+
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file.is_open()) return EDITOR_ERROR_IO;
+
+    std::streamoff size = file.tellg();
+    if (size <= 0) return EDITOR_NOTHING;
+
+    // Decrypted where it was read, then handed to the storage in one copy
+    std::vector<char> text((size_t)size);
+    file.seekg(0);
+    if (!file.read(text.data(), size)) return EDITOR_ERROR_IO;
+    file.close();
+
+    cipher().decryptInPlace(text.data(), text.size(), key);
+
+    bufferCheckpoint(buffer);
+    return bufferAssign(buffer, text.data(), text.size()) == 0 ? EDITOR_OK : EDITOR_ERROR_MEMORY;
+}
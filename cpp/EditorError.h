@@ -0,0 +1,12 @@
+#ifndef EDITOR_ERROR_H
+#define EDITOR_ERROR_H
+
+#include <string>
+
+// The library prints nothing. Code that used to report a problem on stderr
+// leaves its message here instead, one per thread, and editorLastError
+// hands it to the application.
+void setEditorError(const std::string& message);
+void clearEditorError();
+
+#endif // EDITOR_ERROR_H
@@ -0,0 +1,137 @@
+#include "LzCodec.h"
+#include <cstring>
+#include <vector>
+
+namespace {
+
+const size_t MIN_MATCH = 4;
+const size_t MAX_OFFSET = 65535;
+const int HASH_BITS = 14;
+
+unsigned int read32(const char* data) {
+    unsigned int value;
+    memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+unsigned int hash32(unsigned int value) {
+    return (value * 2654435761u) >> (32 - HASH_BITS);
+}
+
+void writeLength(std::string& output, size_t length) {
+    while (length >= 255) {
+        output.push_back((char)255);
+        length -= 255;
+    }
+    output.push_back((char)length);
+}
+
+void writeSequence(std::string& output, const char* literals, size_t literalCount, size_t offset, size_t matchLength) {
+    size_t matchCode = matchLength ? matchLength - MIN_MATCH : 0;
+    unsigned char token = (unsigned char)(((literalCount < 15 ? literalCount : 15) << 4) |
+                                          (matchCode < 15 ? matchCode : 15));
+    output.push_back((char)token);
+    if (literalCount >= 15) {
+        writeLength(output, literalCount - 15);
+    }
+    output.append(literals, literalCount);
+
+    if (matchLength == 0) return;
+
+    output.push_back((char)(offset & 0xFF));
+    output.push_back((char)(offset >> 8));
+    if (matchCode >= 15) {
+        writeLength(output, matchCode - 15);
+    }
+}
+
+bool readLength(const unsigned char*& input, const unsigned char* end, size_t& length) {
+    unsigned char byte;
+    do {
+        if (input >= end) return false;
+        byte = *input++;
+        length += byte;
+    } while (byte == 255);
+    return true;
+}
+
+} // namespace
+
+void LzCodec::compress(const char* input, size_t length, std::string& output) {
+    output.clear();
+    output.reserve(length / 2 + 16);
+
+    // Positions are stored + 1 so that 0 means "empty"
+    std::vector<size_t> table((size_t)1 << HASH_BITS, 0);
+
+    size_t anchor = 0;
+    size_t position = 0;
+
+    while (position + MIN_MATCH <= length) {
+        unsigned int bytes = read32(input + position);
+        unsigned int slot = hash32(bytes);
+        size_t candidate = table[slot];
+        table[slot] = position + 1;
+
+        if (candidate == 0 || position - (candidate - 1) > MAX_OFFSET || read32(input + candidate - 1) != bytes) {
+            position++;
+            continue;
+        }
+
+        candidate--;
+        size_t matchLength = MIN_MATCH;
+        while (position + matchLength < length && input[candidate + matchLength] == input[position + matchLength]) {
+            matchLength++;
+        }
+
+        writeSequence(output, input + anchor, position - anchor, position - candidate, matchLength);
+        position += matchLength;
+        anchor = position;
+    }
+
+    writeSequence(output, input + anchor, length - anchor, 0, 0);
+}
+
+bool LzCodec::decompress(const char* input, size_t length, std::string& output, size_t maxLength) {
+    output.clear();
+    output.reserve(maxLength);
+
+    const unsigned char* cursor = reinterpret_cast<const unsigned char*>(input);
+    const unsigned char* end = cursor + length;
+
+    while (cursor < end) {
+        unsigned char token = *cursor++;
+
+        size_t literalCount = token >> 4;
+        if (literalCount == 15 && !readLength(cursor, end, literalCount)) return false;
+        if (literalCount > (size_t)(end - cursor) || output.size() + literalCount > maxLength) return false;
+
+        output.append(reinterpret_cast<const char*>(cursor), literalCount);
+        cursor += literalCount;
+
+        if (cursor == end) break;
+
+        if (end - cursor < 2) return false;
+        size_t offset = cursor[0] | ((size_t)cursor[1] << 8);
+        cursor += 2;
+
+        size_t matchLength = token & 15;
+        if (matchLength == 15 && !readLength(cursor, end, matchLength)) return false;
+        matchLength += MIN_MATCH;
+
+        if (offset == 0 || offset > output.size() || output.size() + matchLength > maxLength) return false;
+
+        size_t from = output.size() - offset;
+        if (offset >= matchLength) {
+            output.append(output, from, matchLength);
+            continue;
+        }
+
+        // Overlapping match: it repeats bytes it is still producing
+        for (size_t i = 0; i < matchLength; i++) {
+            output.push_back(output[from + i]);
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,23 @@
+#ifndef LZ_CODEC_H
+#define LZ_CODEC_H
+
+#include <cstddef>
+#include <string>
+
+// Small LZ77 codec in the spirit of LZ4: a single hash probe per position,
+// 64 KB window, byte-aligned sequences of (literal run, back reference).
+// Meant for cold in-memory data, so it favours speed over ratio.
+//
+// Sequence format: token byte (high nibble literal count, low nibble match
+// length - 4; 15 means more length bytes follow, each adding up to 255),
+// the literals, then a 2-byte little-endian offset. The final sequence has
+// literals only.
+class LzCodec {
+public:
+    static void compress(const char* input, size_t length, std::string& output);
+
+    // Fails on malformed input or if the result would exceed maxLength
+    static bool decompress(const char* input, size_t length, std::string& output, size_t maxLength);
+};
+
+#endif // LZ_CODEC_H
@@ -0,0 +1,61 @@
+#include "MappedFile.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+MappedFile::MappedFile() : region(nullptr), regionSize(0), length(0) {
+}
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+void MappedFile::close() {
+    if (region) {
+        munmap(region, regionSize);
+        region = nullptr;
+        regionSize = 0;
+        length = 0;
+    }
+}
+
+bool MappedFile::open(const char* path) {
+    close();
+
+    int fd = ::open(path, O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode) || info.st_size <= 0) {
+        ::close(fd);
+        return false;
+    }
+
+    size_t fileSize = (size_t)info.st_size;
+    size_t pageSize = (size_t)sysconf(_SC_PAGESIZE);
+    size_t reserved = (fileSize / pageSize + 1) * pageSize;
+
+    // Reserve one extra zero page past the end, then map the file over the
+    // front of it. The terminating NUL comes for free this way, even when
+    // the file size is an exact multiple of the page size.
+    void* reservation = mmap(nullptr, reserved, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (reservation == MAP_FAILED) {
+        ::close(fd);
+        return false;
+    }
+
+    void* mapped = mmap(reservation, fileSize, PROT_READ, MAP_PRIVATE | MAP_FIXED, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED) {
+        munmap(reservation, reserved);
+        return false;
+    }
+
+    madvise(mapped, fileSize, MADV_SEQUENTIAL);
+
+    region = mapped;
+    regionSize = reserved;
+    length = fileSize;
+    return true;
+}
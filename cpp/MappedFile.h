@@ -0,0 +1,31 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+
+// Read-only memory mapping of a regular file. The mapping is followed by at
+// least one zero byte, so the contents can be used as a C string as well.
+class MappedFile {
+private:
+    void* region;
+    size_t regionSize;
+    size_t length;
+
+    void close();
+
+public:
+    MappedFile();
+    ~MappedFile();
+
+    // Fails for pipes, devices and empty files; callers fall back to reading
+    bool open(const char* path);
+
+    const char* data() const { return static_cast<const char*>(region); }
+    size_t size() const { return length; }
+
+private:
+    MappedFile(const MappedFile&);
+    MappedFile& operator=(const MappedFile&);
+};
+
+#endif // MAPPED_FILE_H
@@ -0,0 +1,86 @@
+#include "ParallelSearch.h"
+
+ParallelSearch::ParallelSearch(const std::string& pattern, size_t threadCount)
+    : search(pattern), pool(threadCount) {
+}
+
+void ParallelSearch::scanChunk(const char* text, size_t length, ChunkResult& chunk) const {
+    size_t patternLength = search.patternLength();
+    size_t limit = chunk.end + patternLength - 1;
+    if (limit > length) {
+        limit = length;
+    }
+
+    const char* base = text + chunk.start;
+    size_t span = limit - chunk.start;
+    size_t chunkLength = chunk.end - chunk.start;
+    LineCursor cursor(base);
+    size_t position = 0;
+
+    // Every occurrence starting inside the chunk; overlaps are resolved when
+    // the chunks are merged, because only then is the previous match known.
+    while ((position = search.find(base, span, position)) < chunkLength) {
+        SearchMatch match;
+        match.length = patternLength;
+        match.patternId = 0;
+        cursor.advanceTo(position, match);
+        chunk.matches.push_back(match);
+        position++;
+    }
+
+    SearchMatch end;
+    cursor.advanceTo(chunkLength, end);
+    chunk.lineFeeds = end.line;
+    chunk.lastLineStart = end.offset - end.column;
+}
+
+std::vector<SearchMatch> ParallelSearch::findAll(const char* text, size_t length) {
+    std::vector<SearchMatch> matches;
+    if (!text || search.patternLength() == 0 || length < search.patternLength()) return matches;
+
+    size_t chunkCount = pool.size() * 4;
+    size_t chunkSize = (length + chunkCount - 1) / chunkCount;
+    if (chunkSize < MIN_CHUNK_SIZE) {
+        chunkSize = MIN_CHUNK_SIZE;
+    }
+    chunkCount = (length + chunkSize - 1) / chunkSize;
+
+    std::vector<ChunkResult> chunks(chunkCount);
+    for (size_t i = 0; i < chunkCount; i++) {
+        ChunkResult& chunk = chunks[i];
+        chunk.start = i * chunkSize;
+        chunk.end = chunk.start + chunkSize < length ? chunk.start + chunkSize : length;
+        pool.submit([this, text, length, &chunk]() { scanChunk(text, length, chunk); });
+    }
+    pool.wait();
+
+    // Merge in order, keeping the sequential non-overlapping semantics
+    size_t lineBase = 0;
+    size_t lineStart = 0;
+    size_t lastEnd = 0;
+
+    for (size_t i = 0; i < chunkCount; i++) {
+        const ChunkResult& chunk = chunks[i];
+
+        for (size_t j = 0; j < chunk.matches.size(); j++) {
+            SearchMatch match = chunk.matches[j];
+            size_t offset = chunk.start + match.offset;
+            if (offset < lastEnd) continue;
+
+            if (match.line == 0) {
+                match.column = offset - lineStart;
+            }
+            match.line += lineBase;
+            match.offset = offset;
+            matches.push_back(match);
+            lastEnd = offset + match.length;
+        }
+
+        lineBase += chunk.lineFeeds;
+        if (chunk.lineFeeds > 0) {
+            lineStart = chunk.start + chunk.lastLineStart;
+        }
+    }
+
+    return matches;
+}
@@ -0,0 +1,41 @@
+#ifndef PARALLEL_SEARCH_H
+#define PARALLEL_SEARCH_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "TextSearch.h"
+#include "ThreadPool.h"
+
+// Literal search over large texts split into chunks that are scanned on a
+// thread pool. Each chunk reads pattern length - 1 bytes past its end so
+// matches across a boundary are not lost, and counts its own line feeds in
+// the same pass so line numbers can be fixed up when results are merged.
+class ParallelSearch {
+private:
+    struct ChunkResult {
+        size_t start;
+        size_t end;
+        std::vector<SearchMatch> matches;
+        size_t lineFeeds;
+        size_t lastLineStart;
+    };
+
+    TextSearch search;
+    ThreadPool pool;
+
+    void scanChunk(const char* text, size_t length, ChunkResult& chunk) const;
+
+public:
+    // Chunks smaller than this are not worth a task of their own
+    static const size_t MIN_CHUNK_SIZE = 1 << 16;
+
+    ParallelSearch(const std::string& pattern, size_t threadCount = 0);
+
+    // Same results as TextSearch::findAll, in the same order
+    std::vector<SearchMatch> findAll(const char* text, size_t length);
+
+    size_t threadCount() const { return pool.size(); }
+};
+
+#endif // PARALLEL_SEARCH_H
@@ -0,0 +1,629 @@
+#include "PieceTable.h"
+#include "MappedFile.h"
+#include <cstring>
+#include <vector>
+#include <algorithm>
+
+PieceTable::SourceBuffer::SourceBuffer() : mapping(nullptr) {
+}
+
+PieceTable::SourceBuffer::~SourceBuffer() {
+    delete mapping;
+}
+
+const char* PieceTable::SourceBuffer::data() const {
+    return mapping ? mapping->data() : text.c_str();
+}
+
+size_t PieceTable::SourceBuffer::size() const {
+    return mapping ? mapping->size() : text.size();
+}
+
+PieceTable::Snapshot::Snapshot() : root(nullptr) {
+}
+
+PieceTable::Snapshot::Snapshot(const Snapshot& other)
+    : root(retain(other.root)), original(other.original), added(other.added) {
+}
+
+PieceTable::Snapshot& PieceTable::Snapshot::operator=(const Snapshot& other) {
+    Node* previous = root;
+    root = retain(other.root);
+    release(previous);
+    original = other.original;
+    added = other.added;
+    return *this;
+}
+
+PieceTable::Snapshot::~Snapshot() {
+    release(root);
+}
+
+void PieceTable::Snapshot::copyRange(size_t offset, size_t length, char* output) const {
+    if (!root) return;
+    copyNodes(root, *original, *added, offset, length, output);
+}
+
+void PieceTable::Snapshot::detachedSegments(std::vector<std::pair<const char*, size_t> >& output,
+                                            std::vector<char>& copies) const {
+    std::vector<const Node*> pieces;
+    collectPieces(root, pieces);
+
+    size_t copied = 0;
+    for (size_t i = 0; i < pieces.size(); i++) {
+        if (pieces[i]->source == SOURCE_ADD) copied += pieces[i]->length;
+    }
+
+    // Reserved up front, so the pointers into copies stay put
+    output.clear();
+    copies.clear();
+    copies.reserve(copied);
+    for (size_t i = 0; i < pieces.size(); i++) {
+        const Node* piece = pieces[i];
+        if (piece->source == SOURCE_ORIGINAL) {
+            output.push_back(std::make_pair(original->data() + piece->start, piece->length));
+        } else {
+            const char* text = added->data() + piece->start;
+            output.push_back(std::make_pair(copies.data() + copies.size(), piece->length));
+            copies.insert(copies.end(), text, text + piece->length);
+        }
+    }
+}
+
+size_t PieceTable::Snapshot::unsharedBytes(const Snapshot& other) const {
+    const BufferRef* buffers[] = {&original, &added};
+    size_t bytes = 0;
+    for (size_t i = 0; i < 2; i++) {
+        const BufferRef& buffer = *buffers[i];
+        if (buffer && !buffer->mapping && buffer != other.original && buffer != other.added) {
+            bytes += buffer->text.size();
+        }
+    }
+    return bytes;
+}
+
+PieceTable::PieceTable()
+    : original(std::make_shared<SourceBuffer>()), added(std::make_shared<SourceBuffer>()), root(nullptr),
+      seed(2463534242u) {
+}
+
+PieceTable::~PieceTable() {
+    release(root);
+}
+
+unsigned int PieceTable::nextPriority() {
+    // xorshift32 - only needs to be cheap and well spread
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+    return seed;
+}
+
+PieceTable::Node* PieceTable::createNode(Source source, size_t start, size_t length, unsigned int priority) {
+    Node* node = new Node;
+    node->source = source;
+    node->start = start;
+    node->length = length;
+    node->lineFeeds = countLineFeeds(source, start, length);
+    node->subtreeLength = length;
+    node->subtreeLineFeeds = node->lineFeeds;
+    node->subtreePieces = 1;
+    node->priority = priority;
+    node->references = 1;
+    node->left = nullptr;
+    node->right = nullptr;
+    return node;
+}
+
+size_t PieceTable::lengthOf(const Node* node) {
+    return node ? node->subtreeLength : 0;
+}
+
+size_t PieceTable::piecesOf(const Node* node) {
+    return node ? node->subtreePieces : 0;
+}
+
+size_t PieceTable::lineFeedsOf(const Node* node) {
+    return node ? node->subtreeLineFeeds : 0;
+}
+
+void PieceTable::update(Node* node) {
+    if (!node) return;
+    node->subtreeLength = lengthOf(node->left) + node->length + lengthOf(node->right);
+    node->subtreeLineFeeds = lineFeedsOf(node->left) + node->lineFeeds + lineFeedsOf(node->right);
+    node->subtreePieces = piecesOf(node->left) + 1 + piecesOf(node->right);
+}
+
+PieceTable::Node* PieceTable::retain(Node* node) {
+    if (node) {
+        node->references++;
+    }
+    return node;
+}
+
+void PieceTable::release(Node* node) {
+    // Iterative on the right spine so long chains don't recurse deeply
+    while (node && --node->references == 0) {
+        Node* right = node->right;
+        release(node->left);
+        delete node;
+        node = right;
+    }
+}
+
+// A node the caller may modify: itself if nobody else holds it, otherwise a
+// copy that takes over the caller's reference
+PieceTable::Node* PieceTable::writable(Node* node) {
+    if (!node || node->references == 1) return node;
+
+    Node* copy = new Node(*node);
+    copy->references = 1;
+    retain(copy->left);
+    retain(copy->right);
+    node->references--;
+    return copy;
+}
+
+void PieceTable::split(Node* node, size_t offset, Node*& left, Node*& right) {
+    if (!node) {
+        left = right = nullptr;
+        return;
+    }
+
+    // Nothing to cut at either end
+    if (offset == 0) {
+        left = nullptr;
+        right = node;
+        return;
+    }
+    if (offset >= node->subtreeLength) {
+        left = node;
+        right = nullptr;
+        return;
+    }
+
+    node = writable(node);
+    size_t leftLength = lengthOf(node->left);
+
+    if (offset <= leftLength) {
+        split(node->left, offset, left, node->left);
+        update(node);
+        right = node;
+    } else if (offset >= leftLength + node->length) {
+        split(node->right, offset - leftLength - node->length, node->right, right);
+        update(node);
+        left = node;
+    } else {
+        // Offset falls inside this piece: cut it in two. The tail keeps the
+        // same priority so it can adopt the right subtree without breaking
+        // the heap order.
+        size_t cut = offset - leftLength;
+        Node* tail = createNode(node->source, node->start + cut, node->length - cut, node->priority);
+        node->length = cut;
+        node->lineFeeds -= tail->lineFeeds;
+        tail->right = node->right;
+        node->right = nullptr;
+        update(tail);
+        update(node);
+        left = node;
+        right = tail;
+    }
+}
+
+PieceTable::Node* PieceTable::merge(Node* left, Node* right) {
+    if (!left) return right;
+    if (!right) return left;
+
+    if (left->priority >= right->priority) {
+        left = writable(left);
+        left->right = merge(left->right, right);
+        update(left);
+        return left;
+    }
+
+    right = writable(right);
+    right->left = merge(left, right->left);
+    update(right);
+    return right;
+}
+
+// Extend the last piece of tree, copying the shared nodes on the way down
+void PieceTable::growLastPiece(Node*& tree, size_t length, size_t lineFeeds) {
+    Node** link = &tree;
+    Node* node = nullptr;
+    while (*link) {
+        node = *link = writable(*link);
+        node->subtreeLength += length;
+        node->subtreeLineFeeds += lineFeeds;
+        link = &node->right;
+    }
+    node->length += length;
+    node->lineFeeds += lineFeeds;
+}
+
+const PieceTable::Node* PieceTable::lastPiece(const Node* node) const {
+    if (!node) return nullptr;
+    while (node->right) {
+        node = node->right;
+    }
+    return node;
+}
+
+const PieceTable::SourceBuffer& PieceTable::sourceBuffer(Source source) const {
+    return source == SOURCE_ORIGINAL ? *original : *added;
+}
+
+const char* PieceTable::sourceData(Source source) const {
+    return sourceBuffer(source).data();
+}
+
+size_t PieceTable::countLineFeeds(Source source, size_t start, size_t length) const {
+    const std::vector<size_t>& lineFeeds = sourceBuffer(source).lineFeeds;
+    std::vector<size_t>::const_iterator first = std::lower_bound(lineFeeds.begin(), lineFeeds.end(), start);
+    std::vector<size_t>::const_iterator last = std::lower_bound(first, lineFeeds.end(), start + length);
+    return last - first;
+}
+
+void PieceTable::indexLineFeeds(const char* text, size_t length, size_t base, std::vector<size_t>& lineFeeds) {
+    const char* end = text + length;
+    const char* cursor = text;
+    while (cursor < end) {
+        const char* found = static_cast<const char*>(memchr(cursor, '\n', end - cursor));
+        if (!found) break;
+        lineFeeds.push_back(base + (found - text));
+        cursor = found + 1;
+    }
+}
+
+void PieceTable::resetOriginal(const BufferRef& buffer) {
+    release(root);
+    root = nullptr;
+
+    // Snapshots may still use the old buffers, so start fresh ones
+    original = buffer;
+    added = std::make_shared<SourceBuffer>();
+    indexLineFeeds(original->data(), original->size(), 0, original->lineFeeds);
+
+    if (original->size() > 0) {
+        root = createNode(SOURCE_ORIGINAL, 0, original->size(), nextPriority());
+    }
+}
+
+size_t PieceTable::appendToAddBuffer(const char* text, size_t length, size_t& lineFeeds) {
+    size_t addStart = added->text.size();
+    added->text.append(text, length);
+
+    lineFeeds = added->lineFeeds.size();
+    indexLineFeeds(text, length, addStart, added->lineFeeds);
+    lineFeeds = added->lineFeeds.size() - lineFeeds;
+    return addStart;
+}
+
+void PieceTable::reset(const char* text, size_t length) {
+    // Copy first: text may point into the buffer being replaced
+    std::string copy(text ? text : "", text ? length : 0);
+    reset(copy);
+}
+
+void PieceTable::reset(std::string& text) {
+    BufferRef buffer = std::make_shared<SourceBuffer>();
+    buffer->text.swap(text);
+    resetOriginal(buffer);
+}
+
+void PieceTable::reset(MappedFile* mapping) {
+    if (!mapping) return;
+
+    BufferRef buffer = std::make_shared<SourceBuffer>();
+    buffer->mapping = mapping;
+    resetOriginal(buffer);
+}
+
+bool PieceTable::insert(size_t offset, const char* text, size_t length) {
+    if (offset > this->length()) return false;
+    if (!text || length == 0) return true;
+
+    size_t newLineFeeds;
+    size_t addStart = appendToAddBuffer(text, length, newLineFeeds);
+
+    Node* left;
+    Node* right;
+    split(root, offset, left, right);
+
+    // Typing at the end of the previous insert just grows that piece
+    const Node* previous = lastPiece(left);
+    if (previous && previous->source == SOURCE_ADD && previous->start + previous->length == addStart) {
+        growLastPiece(left, length, newLineFeeds);
+        root = merge(left, right);
+        return true;
+    }
+
+    Node* piece = createNode(SOURCE_ADD, addStart, length, nextPriority());
+    root = merge(merge(left, piece), right);
+    return true;
+}
+
+bool PieceTable::append(const char* text, size_t length) {
+    if (!text || length == 0) return true;
+
+    size_t newLineFeeds;
+    size_t addStart = appendToAddBuffer(text, length, newLineFeeds);
+
+    const Node* previous = lastPiece(root);
+    if (previous && previous->source == SOURCE_ADD && previous->start + previous->length == addStart) {
+        growLastPiece(root, length, newLineFeeds);
+        return true;
+    }
+
+    root = merge(root, createNode(SOURCE_ADD, addStart, length, nextPriority()));
+    return true;
+}
+
+void PieceTable::reserveAppend(size_t length) {
+    std::string& text = added->text;
+    if (text.capacity() - text.size() < length) {
+        text.reserve(text.size() + length);
+    }
+}
+
+bool PieceTable::erase(size_t offset, size_t length) {
+    size_t total = this->length();
+    if (offset > total) return false;
+    if (length > total - offset) {
+        length = total - offset;
+    }
+    if (length == 0) return true;
+
+    Node* left;
+    Node* middle;
+    Node* right;
+    split(root, offset, left, right);
+    split(right, length, middle, right);
+
+    release(middle);
+    root = merge(left, right);
+    return true;
+}
+
+bool PieceTable::applyEdits(const std::vector<Edit>& edits) {
+    size_t total = this->length();
+    size_t end = 0;
+    for (size_t i = 0; i < edits.size(); i++) {
+        const Edit& edit = edits[i];
+        if (edit.offset < end || edit.offset > total || edit.eraseLength > total - edit.offset) return false;
+        end = edit.offset + edit.eraseLength;
+    }
+
+    // Peel the untouched text off the front of the remaining tree one edit
+    // at a time, dropping erased ranges and adding inserted pieces
+    Node* rest = root;
+    Node* done = nullptr;
+    size_t consumed = 0;   // old offset where rest begins
+    root = nullptr;
+
+    for (size_t i = 0; i < edits.size(); i++) {
+        const Edit& edit = edits[i];
+        Node* kept;
+        split(rest, edit.offset - consumed, kept, rest);
+        done = merge(done, kept);
+
+        if (edit.eraseLength > 0) {
+            Node* removed;
+            split(rest, edit.eraseLength, removed, rest);
+            release(removed);
+        }
+        consumed = edit.offset + edit.eraseLength;
+
+        if (edit.text && edit.length > 0) {
+            size_t newLineFeeds;
+            size_t addStart = appendToAddBuffer(edit.text, edit.length, newLineFeeds);
+            done = merge(done, createNode(SOURCE_ADD, addStart, edit.length, nextPriority()));
+        }
+    }
+
+    root = merge(done, rest);
+    return true;
+}
+
+PieceTable::Snapshot PieceTable::snapshot() const {
+    Snapshot version;
+    version.root = retain(root);
+    version.original = original;
+    version.added = added;
+    return version;
+}
+
+void PieceTable::restore(const Snapshot& snapshot) {
+    Node* previous = root;
+    root = retain(snapshot.root);
+    release(previous);
+    original = snapshot.original;
+    added = snapshot.added;
+}
+
+size_t PieceTable::length() const {
+    return lengthOf(root);
+}
+
+size_t PieceTable::pieceCount() const {
+    return piecesOf(root);
+}
+
+void PieceTable::copyRange(size_t offset, size_t length, char* output) const {
+    copyNodes(root, *original, *added, offset, length, output);
+}
+
+void PieceTable::copyNodes(const Node* root, const SourceBuffer& original, const SourceBuffer& added,
+                           size_t offset, size_t length, char* output) {
+    if (!output || length == 0) return;
+
+    // Walk down to the first piece of the range, remembering the ancestors
+    // we still have to visit in order.
+    std::vector<const Node*> stack;
+    const Node* node = root;
+    size_t skip = offset;
+
+    while (node) {
+        size_t leftLength = lengthOf(node->left);
+        if (skip < leftLength) {
+            stack.push_back(node);
+            node = node->left;
+        } else if (skip < leftLength + node->length) {
+            skip -= leftLength;
+            stack.push_back(node);
+            break;
+        } else {
+            skip -= leftLength + node->length;
+            node = node->right;
+        }
+    }
+
+    size_t written = 0;
+    while (!stack.empty() && written < length) {
+        const Node* current = stack.back();
+        stack.pop_back();
+
+        size_t available = current->length - skip;
+        size_t chunk = available < length - written ? available : length - written;
+        const SourceBuffer& source = current->source == SOURCE_ORIGINAL ? original : added;
+        memcpy(output + written, source.data() + current->start + skip, chunk);
+        written += chunk;
+        skip = 0;
+
+        for (const Node* next = current->right; next; next = next->left) {
+            stack.push_back(next);
+        }
+    }
+}
+
+void PieceTable::copyTo(char* output) const {
+    copyRange(0, length(), output);
+}
+
+void PieceTable::collectPieces(const Node* root, std::vector<const Node*>& output) {
+    output.reserve(output.size() + piecesOf(root));
+
+    std::vector<const Node*> stack;
+    const Node* node = root;
+    while (node || !stack.empty()) {
+        while (node) {
+            stack.push_back(node);
+            node = node->left;
+        }
+        node = stack.back();
+        stack.pop_back();
+
+        output.push_back(node);
+        node = node->right;
+    }
+}
+
+void PieceTable::segments(std::vector<std::pair<const char*, size_t> >& output) const {
+    output.clear();
+    output.reserve(pieceCount());
+
+    std::vector<const Node*> stack;
+    const Node* node = root;
+    while (node || !stack.empty()) {
+        while (node) {
+            stack.push_back(node);
+            node = node->left;
+        }
+        node = stack.back();
+        stack.pop_back();
+
+        output.push_back(std::make_pair(sourceData(node->source) + node->start, node->length));
+        node = node->right;
+    }
+}
+
+const char* PieceTable::originalView() const {
+    size_t originalLength = original->size();
+    if (!root) return originalLength == 0 ? original->data() : nullptr;
+
+    if (root->left || root->right || root->source != SOURCE_ORIGINAL ||
+        root->start != 0 || root->length != originalLength) {
+        return nullptr;
+    }
+    return original->data();
+}
+
+size_t PieceTable::lineCount() const {
+    return lineFeedsOf(root) + 1;
+}
+
+bool PieceTable::lineStart(size_t line, size_t& offset) const {
+    if (line == 0) {
+        offset = 0;
+        return true;
+    }
+    if (line > lineFeedsOf(root)) return false;
+
+    // Find the line-th line feed; the line starts right after it
+    size_t remaining = line;
+    size_t base = 0;
+    const Node* node = root;
+
+    while (node) {
+        size_t leftFeeds = lineFeedsOf(node->left);
+        if (remaining <= leftFeeds) {
+            node = node->left;
+        } else if (remaining <= leftFeeds + node->lineFeeds) {
+            remaining -= leftFeeds;
+            const std::vector<size_t>& lineFeeds = sourceBuffer(node->source).lineFeeds;
+            size_t first = std::lower_bound(lineFeeds.begin(), lineFeeds.end(), node->start) - lineFeeds.begin();
+            size_t feed = lineFeeds[first + remaining - 1];
+            offset = base + lengthOf(node->left) + (feed - node->start) + 1;
+            return true;
+        } else {
+            remaining -= leftFeeds + node->lineFeeds;
+            base += lengthOf(node->left) + node->length;
+            node = node->right;
+        }
+    }
+
+    return false;
+}
+
+bool PieceTable::lineLength(size_t line, size_t& length) const {
+    size_t start;
+    if (!lineStart(line, start)) return false;
+
+    size_t next;
+    if (lineStart(line + 1, next)) {
+        length = next - 1 - start;
+    } else {
+        length = this->length() - start;
+    }
+    return true;
+}
+
+bool PieceTable::positionOf(size_t offset, size_t& line, size_t& column) const {
+    if (offset > length()) return false;
+
+    // Count the line feeds in front of offset
+    size_t lineFeeds = 0;
+    size_t skip = offset;
+    const Node* node = root;
+
+    while (node) {
+        size_t leftLength = lengthOf(node->left);
+        if (skip < leftLength) {
+            node = node->left;
+        } else if (skip < leftLength + node->length) {
+            lineFeeds += lineFeedsOf(node->left);
+            lineFeeds += countLineFeeds(node->source, node->start, skip - leftLength);
+            break;
+        } else {
+            lineFeeds += lineFeedsOf(node->left) + node->lineFeeds;
+            skip -= leftLength + node->length;
+            node = node->right;
+        }
+    }
+
+    size_t start;
+    lineStart(lineFeeds, start);
+    line = lineFeeds;
+    column = offset - start;
+    return true;
+}
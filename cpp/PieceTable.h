@@ -0,0 +1,179 @@
+#ifndef PIECE_TABLE_H
+#define PIECE_TABLE_H
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+class MappedFile;
+
+// Piece table storage: the text is described by a sequence of pieces that
+// point into a read-only original buffer or an append-only add buffer. The
+// original buffer is either owned text or a read-only file mapping.
+// Pieces are kept in a treap ordered by position, so edits cost O(log pieces)
+// and existing text is never moved. Each node also carries its line feed
+// count, which turns (line, column) <-> offset lookups into O(log) walks.
+//
+// The treap is persistent: nodes are reference counted and an edit copies
+// only the nodes on its path when they are shared, so a Snapshot of the
+// whole text is just another reference to the root. Versions share every
+// unchanged node and both buffers, and restoring one is O(1).
+class PieceTable {
+private:
+    enum Source {
+        SOURCE_ORIGINAL = 0,
+        SOURCE_ADD = 1
+    };
+
+    struct Node {
+        Source source;
+        size_t start;
+        size_t length;
+        size_t lineFeeds;
+        size_t subtreeLength;
+        size_t subtreeLineFeeds;
+        size_t subtreePieces;
+        unsigned int priority;
+        unsigned int references;
+        Node* left;
+        Node* right;
+    };
+
+    // Backing text of one source. The add buffer only ever grows, so pieces
+    // of older versions stay valid while newer versions append to it.
+    struct SourceBuffer {
+        std::string text;
+        MappedFile* mapping;
+        std::vector<size_t> lineFeeds;   // offsets of every '\n'
+
+        SourceBuffer();
+        ~SourceBuffer();
+        const char* data() const;
+        size_t size() const;
+    };
+
+    typedef std::shared_ptr<SourceBuffer> BufferRef;
+
+    BufferRef original;
+    BufferRef added;
+    Node* root;
+    unsigned int seed;
+
+    // Treap helpers; functions taking or returning Node* transfer one reference
+    Node* createNode(Source source, size_t start, size_t length, unsigned int priority);
+    unsigned int nextPriority();
+    static size_t lengthOf(const Node* node);
+    static size_t piecesOf(const Node* node);
+    static size_t lineFeedsOf(const Node* node);
+    static void update(Node* node);
+    static Node* retain(Node* node);
+    static void release(Node* node);
+    static Node* writable(Node* node);
+    void split(Node* node, size_t offset, Node*& left, Node*& right);
+    Node* merge(Node* left, Node* right);
+    void growLastPiece(Node*& tree, size_t length, size_t lineFeeds);
+    const Node* lastPiece(const Node* node) const;
+    const SourceBuffer& sourceBuffer(Source source) const;
+    const char* sourceData(Source source) const;
+    size_t countLineFeeds(Source source, size_t start, size_t length) const;
+    static void collectPieces(const Node* root, std::vector<const Node*>& output);
+    static void copyNodes(const Node* root, const SourceBuffer& original, const SourceBuffer& added,
+                          size_t offset, size_t length, char* output);
+    static void indexLineFeeds(const char* text, size_t length, size_t base, std::vector<size_t>& lineFeeds);
+    void resetOriginal(const BufferRef& buffer);
+    size_t appendToAddBuffer(const char* text, size_t length, size_t& lineFeeds);
+
+public:
+    // An immutable version of the text
+    class Snapshot {
+    private:
+        friend class PieceTable;
+
+        Node* root;
+        BufferRef original;
+        BufferRef added;
+
+    public:
+        Snapshot();
+        Snapshot(const Snapshot& other);
+        Snapshot& operator=(const Snapshot& other);
+        ~Snapshot();
+
+        size_t length() const { return lengthOf(root); }
+        void copyRange(size_t offset, size_t length, char* output) const;
+
+        // The text as runs that another thread can read while the table
+        // goes on being edited. Runs in the original buffer point into it,
+        // since it never changes and the snapshot keeps it alive. Runs in
+        // the add buffer, which moves as it grows, are copied into copies
+        // first. Valid while both the snapshot and copies are; moving copies
+        // keeps them valid too.
+        void detachedSegments(std::vector<std::pair<const char*, size_t> >& output, std::vector<char>& copies) const;
+
+        // Bytes of the buffers this version uses that other does not share.
+        // Mapped files are not counted: the kernel can drop and reread their
+        // pages at any time.
+        size_t unsharedBytes(const Snapshot& other) const;
+    };
+
+    PieceTable();
+    ~PieceTable();
+
+    // Replace the whole text; the new text becomes the original buffer
+    void reset(const char* text, size_t length);
+    void reset(std::string& text);       // takes the string's contents
+    void reset(MappedFile* mapping);     // takes ownership of the mapping
+
+    // Editing
+    bool insert(size_t offset, const char* text, size_t length);
+    bool erase(size_t offset, size_t length);
+
+    // One edit of a batch, with offsets into the text before the batch
+    struct Edit {
+        size_t offset;
+        size_t eraseLength;
+        const char* text;
+        size_t length;
+    };
+
+    // Apply edits sorted by offset and not overlapping (inserts may share an
+    // offset) in one left-to-right pass over the tree: O(k log pieces) for k
+    // edits, however far apart they are. Nothing changes if one is invalid.
+    bool applyEdits(const std::vector<Edit>& edits);
+
+    // Append at the end without splitting; consecutive appends keep growing
+    // one piece, so streaming text in costs amortized O(1) per byte
+    bool append(const char* text, size_t length);
+    void reserveAppend(size_t length);
+
+    // Versions, both O(1)
+    Snapshot snapshot() const;
+    void restore(const Snapshot& snapshot);
+
+    // Reading
+    size_t length() const;
+    size_t pieceCount() const;
+    void copyRange(size_t offset, size_t length, char* output) const;
+    void copyTo(char* output) const;
+
+    // The text as (pointer, length) runs in order, without copying it
+    void segments(std::vector<std::pair<const char*, size_t> >& output) const;
+
+    // NUL-terminated pointer to the whole text when it is still exactly the
+    // untouched original buffer, otherwise nullptr
+    const char* originalView() const;
+
+    // Line index
+    size_t lineCount() const;
+    bool lineStart(size_t line, size_t& offset) const;
+    bool lineLength(size_t line, size_t& length) const;
+    bool positionOf(size_t offset, size_t& line, size_t& column) const;
+
+private:
+    PieceTable(const PieceTable&);
+    PieceTable& operator=(const PieceTable&);
+};
+
+#endif // PIECE_TABLE_H
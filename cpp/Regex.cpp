@@ -0,0 +1,624 @@
+#include "Regex.h"
+#include "TextSearch.h"
+#include <algorithm>
+
+// ---- Lazy DFA ----
+
+Regex::Dfa::Dfa()
+    : nfa(nullptr), sets(nullptr), searching(false), lineStarts(false), lineEnds(false), maxStates(0),
+      midLineStart(0), flushes(0) {
+}
+
+void Regex::Dfa::init(const Nfa* nfa, const std::vector<ByteSet>* sets, size_t maxStates) {
+    searching = false;
+    lineStarts = false;
+    lineEnds = false;
+    setup(nfa, sets, maxStates);
+}
+
+void Regex::Dfa::initSearch(const Nfa* nfa, const std::vector<ByteSet>* sets, bool lineStarts, bool lineEnds,
+                            size_t maxStates) {
+    searching = true;
+    this->lineStarts = lineStarts;
+    this->lineEnds = lineEnds;
+    setup(nfa, sets, maxStates);
+}
+
+void Regex::Dfa::setup(const Nfa* nfa, const std::vector<ByteSet>* sets, size_t maxStates) {
+    this->nfa = nfa;
+    this->sets = sets;
+    this->maxStates = maxStates < 4 ? 4 : maxStates;
+    flushes = 0;
+
+    std::vector<char> seen(nfa->states.size(), 0);
+    startSet.clear();
+    addClosure(nfa->start, startSet, seen);
+    std::sort(startSet.begin(), startSet.end());
+
+    reset();
+}
+
+void Regex::Dfa::addClosure(int nfaState, std::vector<int>& output, std::vector<char>& seen) const {
+    if (nfaState < 0 || seen[nfaState]) return;
+    seen[nfaState] = 1;
+
+    const NfaState& state = nfa->states[nfaState];
+    if (state.type == NFA_SPLIT) {
+        addClosure(state.out, output, seen);
+        addClosure(state.out1, output, seen);
+    } else {
+        output.push_back(nfaState);
+    }
+}
+
+void Regex::Dfa::move(const std::vector<int>& current, unsigned char byte, std::vector<int>& output,
+                      std::vector<char>& seen) const {
+    for (size_t i = 0; i < current.size(); i++) {
+        const NfaState& nfaState = nfa->states[current[i]];
+        if (nfaState.type == NFA_BYTES && (*sets)[nfaState.set].test(byte)) {
+            addClosure(nfaState.out, output, seen);
+        }
+    }
+}
+
+void Regex::Dfa::keepLeftmostMatch(std::vector<std::vector<int> >& groups, bool& sawMatch) const {
+    for (size_t i = 0; i < groups.size(); i++) {
+        for (size_t j = 0; j < groups[i].size(); j++) {
+            if (nfa->states[groups[i][j]].type == NFA_MATCH) {
+                groups.resize(i + 1);
+                sawMatch = true;
+                return;
+            }
+        }
+    }
+}
+
+std::vector<int> Regex::Dfa::searchStep(const std::vector<int>& key, unsigned char byte) const {
+    std::vector<std::vector<int> > groups(1);
+    bool sawMatch = false;
+    for (size_t i = 0; i < key.size(); i++) {
+        if (key[i] == MARK) {
+            groups.push_back(std::vector<int>());
+        } else if (key[i] == SAW_MATCH) {
+            sawMatch = true;
+        } else {
+            groups.back().push_back(key[i]);
+        }
+    }
+    groups.pop_back();
+
+    // A match waiting for the end of its line has it now
+    if (lineEnds && byte == '\n') keepLeftmostMatch(groups, sawMatch);
+
+    std::vector<std::vector<int> > next;
+    std::vector<char> seen(nfa->states.size(), 0);
+    for (size_t i = 0; i < groups.size(); i++) {
+        std::vector<int> moved;
+        move(groups[i], byte, moved, seen);
+        if (!moved.empty()) next.push_back(moved);
+    }
+
+    // Until something matches, a thread starts after every byte (every
+    // newline when anchored). Matches are non-empty, so it cannot match yet.
+    if (!sawMatch && (!lineStarts || byte == '\n')) {
+        std::vector<int> fresh;
+        for (size_t i = 0; i < startSet.size(); i++) {
+            if (!seen[startSet[i]] && nfa->states[startSet[i]].type != NFA_MATCH) {
+                seen[startSet[i]] = 1;
+                fresh.push_back(startSet[i]);
+            }
+        }
+        if (!fresh.empty()) next.push_back(fresh);
+    }
+
+    if (!lineEnds) keepLeftmostMatch(next, sawMatch);
+
+    std::vector<int> nextKey;
+    for (size_t i = 0; i < next.size(); i++) {
+        std::sort(next[i].begin(), next[i].end());
+        nextKey.insert(nextKey.end(), next[i].begin(), next[i].end());
+        nextKey.push_back(MARK);
+    }
+    if (sawMatch) nextKey.push_back(SAW_MATCH);
+    return nextKey;
+}
+
+int Regex::Dfa::intern(std::vector<int>& key) {
+    std::map<std::vector<int>, int>::const_iterator found = index.find(key);
+    if (found != index.end()) return found->second;
+
+    State state;
+    state.key.swap(key);
+    state.accepting = false;
+    for (size_t i = 0; i < state.key.size(); i++) {
+        if (state.key[i] >= 0 && nfa->states[state.key[i]].type == NFA_MATCH) {
+            state.accepting = true;
+            break;
+        }
+    }
+    for (int i = 0; i < 256; i++) {
+        state.next[i] = -1;
+    }
+
+    int id = (int)states.size();
+    states.push_back(state);
+    index[states.back().key] = id;
+    return id;
+}
+
+void Regex::Dfa::reset() {
+    states.clear();
+    index.clear();
+
+    // State 0 is the start state, state 1 the dead state. A search starts
+    // with one thread, which has read nothing and so cannot match yet.
+    std::vector<int> start;
+    std::vector<int> dead;
+    if (searching) {
+        for (size_t i = 0; i < startSet.size(); i++) {
+            if (nfa->states[startSet[i]].type != NFA_MATCH) start.push_back(startSet[i]);
+        }
+        if (!start.empty()) start.push_back(MARK);
+        dead.push_back(SAW_MATCH);
+    } else {
+        start = startSet;
+    }
+    intern(start);
+    intern(dead);
+    for (int i = 0; i < 256; i++) {
+        states[1].next[i] = 1;
+    }
+
+    // A search that must start at a line start has no thread mid-line
+    std::vector<int> none;
+    midLineStart = searching && lineStarts ? intern(none) : 0;
+}
+
+int Regex::Dfa::step(int state, unsigned char byte) {
+    int cached = states[state].next[byte];
+    if (cached >= 0) return cached;
+
+    std::vector<int> next;
+    if (searching) {
+        next = searchStep(states[state].key, byte);
+    } else {
+        std::vector<char> seen(nfa->states.size(), 0);
+        move(states[state].key, byte, next, seen);
+        std::sort(next.begin(), next.end());
+    }
+
+    // Cache full: drop every state and keep going from the new one
+    if (states.size() >= maxStates) {
+        reset();
+        flushes++;
+        return intern(next);
+    }
+
+    int id = intern(next);
+    states[state].next[byte] = id;
+    return id;
+}
+
+// ---- Parser ----
+
+Regex::Regex(const std::string& expression, size_t maxCachedStates)
+    : pattern(expression), position(0), anchoredStart(false), anchoredEnd(false), root(-1) {
+    size_t end = pattern.size();
+
+    if (end > 0 && pattern[0] == '^') {
+        anchoredStart = true;
+        position = 1;
+    }
+
+    if (end > position && pattern[end - 1] == '$') {
+        // Only an unescaped '$' is an anchor
+        size_t backslashes = 0;
+        for (size_t i = end - 1; i > position && pattern[i - 1] == '\\'; i--) {
+            backslashes++;
+        }
+        if (backslashes % 2 == 0) {
+            anchoredEnd = true;
+            this->pattern.erase(end - 1);
+        }
+    }
+
+    root = parseAlternation();
+    if (root >= 0 && position < this->pattern.size()) {
+        errorMessage = "Unmatched ')'";
+    }
+    if (!errorMessage.empty()) return;
+
+    bool complete = true;
+    extractPrefix(root, complete);
+
+    buildNfa(forwardNfa, false);
+    buildNfa(reverseNfa, true);
+    forward.initSearch(&forwardNfa, &sets, anchoredStart, anchoredEnd, maxCachedStates);
+    reverse.init(&reverseNfa, &sets, maxCachedStates);
+}
+
+int Regex::addNode(NodeType type, int left, int right, int set) {
+    Node node;
+    node.type = type;
+    node.left = left;
+    node.right = right;
+    node.set = set;
+    nodes.push_back(node);
+    return (int)nodes.size() - 1;
+}
+
+int Regex::parseAlternation() {
+    int left = parseConcat();
+    if (left < 0) return -1;
+
+    while (position < pattern.size() && pattern[position] == '|') {
+        position++;
+        int right = parseConcat();
+        if (right < 0) return -1;
+        left = addNode(NODE_ALTERNATE, left, right, -1);
+    }
+
+    return left;
+}
+
+int Regex::parseConcat() {
+    int node = -1;
+
+    while (position < pattern.size() && pattern[position] != '|' && pattern[position] != ')') {
+        int next = parseRepeat();
+        if (next < 0) return -1;
+        node = node < 0 ? next : addNode(NODE_CONCAT, node, next, -1);
+    }
+
+    return node < 0 ? addNode(NODE_EMPTY, -1, -1, -1) : node;
+}
+
+int Regex::parseRepeat() {
+    int atom = parseAtom();
+    if (atom < 0) return -1;
+
+    while (position < pattern.size()) {
+        char c = pattern[position];
+        if (c == '*') {
+            atom = addNode(NODE_STAR, atom, -1, -1);
+        } else if (c == '+') {
+            atom = addNode(NODE_PLUS, atom, -1, -1);
+        } else if (c == '?') {
+            atom = addNode(NODE_QUEST, atom, -1, -1);
+        } else {
+            break;
+        }
+        position++;
+    }
+
+    return atom;
+}
+
+int Regex::parseAtom() {
+    char c = pattern[position];
+    ByteSet set;
+
+    switch (c) {
+        case '(': {
+            position++;
+            int inner = parseAlternation();
+            if (inner < 0) return -1;
+            if (position >= pattern.size() || pattern[position] != ')') {
+                errorMessage = "Missing ')'";
+                return -1;
+            }
+            position++;
+            return inner;
+        }
+        case '[':
+            position++;
+            if (!parseClass(set)) return -1;
+            break;
+        case '.':
+            position++;
+            set.set();
+            set.reset('\n');
+            break;
+        case '\\':
+            position++;
+            if (!parseEscape(set)) return -1;
+            break;
+        case '*':
+        case '+':
+        case '?':
+            errorMessage = "Nothing to repeat";
+            return -1;
+        case '^':
+        case '$':
+            errorMessage = "Anchors are only supported at the start and end of the pattern";
+            return -1;
+        default:
+            position++;
+            set.set((unsigned char)c);
+            break;
+    }
+
+    sets.push_back(set);
+    return addNode(NODE_BYTES, -1, -1, (int)sets.size() - 1);
+}
+
+bool Regex::parseEscape(ByteSet& set) {
+    if (position >= pattern.size()) {
+        errorMessage = "Trailing backslash";
+        return false;
+    }
+
+    char c = pattern[position++];
+    ByteSet digits, word, space;
+    for (int i = '0'; i <= '9'; i++) digits.set(i);
+    word = digits;
+    for (int i = 'a'; i <= 'z'; i++) word.set(i);
+    for (int i = 'A'; i <= 'Z'; i++) word.set(i);
+    word.set('_');
+    space.set(' '); space.set('\t'); space.set('\n');
+    space.set('\r'); space.set('\f'); space.set('\v');
+
+    switch (c) {
+        case 'd': set |= digits; break;
+        case 'D': set |= ~digits; break;
+        case 'w': set |= word; break;
+        case 'W': set |= ~word; break;
+        case 's': set |= space; break;
+        case 'S': set |= ~space; break;
+        case 'n': set.set('\n'); break;
+        case 't': set.set('\t'); break;
+        case 'r': set.set('\r'); break;
+        default: set.set((unsigned char)c); break;
+    }
+
+    return true;
+}
+
+bool Regex::parseClass(ByteSet& set) {
+    bool negated = false;
+    if (position < pattern.size() && pattern[position] == '^') {
+        negated = true;
+        position++;
+    }
+
+    bool first = true;
+    while (position < pattern.size() && (pattern[position] != ']' || first)) {
+        first = false;
+        unsigned char low = (unsigned char)pattern[position];
+
+        if (low == '\\') {
+            position++;
+            if (!parseEscape(set)) return false;
+            continue;
+        }
+        position++;
+
+        if (position + 1 < pattern.size() && pattern[position] == '-' && pattern[position + 1] != ']') {
+            unsigned char high = (unsigned char)pattern[position + 1];
+            position += 2;
+            if (high < low) {
+                errorMessage = "Invalid range in character class";
+                return false;
+            }
+            for (int i = low; i <= high; i++) {
+                set.set(i);
+            }
+        } else {
+            set.set(low);
+        }
+    }
+
+    if (position >= pattern.size()) {
+        errorMessage = "Missing ']'";
+        return false;
+    }
+    position++;
+
+    if (negated) {
+        set.flip();
+    }
+    return true;
+}
+
+void Regex::extractPrefix(int node, bool& complete) {
+    if (!complete) return;
+
+    const Node& current = nodes[node];
+    if (current.type == NODE_CONCAT) {
+        extractPrefix(current.left, complete);
+        extractPrefix(current.right, complete);
+        return;
+    }
+
+    if (current.type == NODE_BYTES && sets[current.set].count() == 1) {
+        for (int i = 0; i < 256; i++) {
+            if (sets[current.set].test(i)) {
+                literalPrefix += (char)i;
+                break;
+            }
+        }
+        return;
+    }
+
+    complete = false;
+}
+
+// ---- NFA construction ----
+
+void Regex::patch(Nfa& nfa, const std::vector<std::pair<int, int> >& dangling, int target) {
+    for (size_t i = 0; i < dangling.size(); i++) {
+        NfaState& state = nfa.states[dangling[i].first];
+        if (dangling[i].second == 0) {
+            state.out = target;
+        } else {
+            state.out1 = target;
+        }
+    }
+}
+
+int Regex::compile(Nfa& nfa, int node, bool reversed, std::vector<std::pair<int, int> >& dangling) {
+    const Node current = nodes[node];
+    NfaState state;
+    state.out = -1;
+    state.out1 = -1;
+    state.set = -1;
+
+    switch (current.type) {
+        case NODE_EMPTY: {
+            state.type = NFA_SPLIT;
+            nfa.states.push_back(state);
+            int id = (int)nfa.states.size() - 1;
+            dangling.push_back(std::make_pair(id, 0));
+            return id;
+        }
+        case NODE_BYTES: {
+            state.type = NFA_BYTES;
+            state.set = current.set;
+            nfa.states.push_back(state);
+            int id = (int)nfa.states.size() - 1;
+            dangling.push_back(std::make_pair(id, 0));
+            return id;
+        }
+        case NODE_CONCAT: {
+            std::vector<std::pair<int, int> > firstOut;
+            int first = compile(nfa, reversed ? current.right : current.left, reversed, firstOut);
+            int second = compile(nfa, reversed ? current.left : current.right, reversed, dangling);
+            patch(nfa, firstOut, second);
+            return first;
+        }
+        case NODE_ALTERNATE: {
+            state.type = NFA_SPLIT;
+            nfa.states.push_back(state);
+            int id = (int)nfa.states.size() - 1;
+            int left = compile(nfa, current.left, reversed, dangling);
+            int right = compile(nfa, current.right, reversed, dangling);
+            nfa.states[id].out = left;
+            nfa.states[id].out1 = right;
+            return id;
+        }
+        case NODE_STAR: {
+            state.type = NFA_SPLIT;
+            nfa.states.push_back(state);
+            int id = (int)nfa.states.size() - 1;
+            std::vector<std::pair<int, int> > bodyOut;
+            int body = compile(nfa, current.left, reversed, bodyOut);
+            patch(nfa, bodyOut, id);
+            nfa.states[id].out = body;
+            dangling.push_back(std::make_pair(id, 1));
+            return id;
+        }
+        case NODE_PLUS: {
+            std::vector<std::pair<int, int> > bodyOut;
+            int body = compile(nfa, current.left, reversed, bodyOut);
+            state.type = NFA_SPLIT;
+            state.out = body;
+            nfa.states.push_back(state);
+            int id = (int)nfa.states.size() - 1;
+            patch(nfa, bodyOut, id);
+            dangling.push_back(std::make_pair(id, 1));
+            return body;
+        }
+        case NODE_QUEST: {
+            state.type = NFA_SPLIT;
+            nfa.states.push_back(state);
+            int id = (int)nfa.states.size() - 1;
+            int body = compile(nfa, current.left, reversed, dangling);
+            nfa.states[id].out = body;
+            dangling.push_back(std::make_pair(id, 1));
+            return id;
+        }
+    }
+
+    return -1;
+}
+
+void Regex::buildNfa(Nfa& nfa, bool reversed) {
+    nfa.states.clear();
+
+    std::vector<std::pair<int, int> > dangling;
+    nfa.start = compile(nfa, root, reversed, dangling);
+
+    NfaState match;
+    match.type = NFA_MATCH;
+    match.out = -1;
+    match.out1 = -1;
+    match.set = -1;
+    nfa.states.push_back(match);
+    patch(nfa, dangling, (int)nfa.states.size() - 1);
+}
+
+// ---- Matching ----
+
+bool Regex::isLineStart(const char* text, size_t offset) const {
+    return offset == 0 || text[offset - 1] == '\n';
+}
+
+// End of the leftmost-longest match that starts at or after from, or from
+// if there is none
+size_t Regex::matchEnd(const char* text, size_t length, size_t from) {
+    int state = forward.start(isLineStart(text, from));
+    size_t end = from;
+
+    for (size_t i = from; i < length; i++) {
+        unsigned char byte = (unsigned char)text[i];
+        if (anchoredEnd && byte == '\n' && forward.isAccepting(state)) end = i;
+        state = forward.step(state, byte);
+        if (forward.isDead(state)) return end;
+        if (!anchoredEnd && forward.isAccepting(state)) end = i + 1;
+    }
+
+    if (anchoredEnd && forward.isAccepting(state)) end = length;
+    return end;
+}
+
+// Leftmost start, not before from, of a match that ends at end
+size_t Regex::matchStart(const char* text, size_t from, size_t end) {
+    int state = reverse.start();
+    size_t start = end;
+
+    for (size_t i = end; i > from; i--) {
+        state = reverse.step(state, (unsigned char)text[i - 1]);
+        if (reverse.isDead(state)) break;
+        if (reverse.isAccepting(state) && (!anchoredStart || isLineStart(text, i - 1))) start = i - 1;
+    }
+
+    return start;
+}
+
+std::vector<SearchMatch> Regex::findMatches(const char* text, size_t length, size_t limit) {
+    std::vector<SearchMatch> matches;
+    if (!isValid() || !text || limit == 0) return matches;
+
+    TextSearch prefixSearch(literalPrefix);
+    LineCursor cursor(text);
+    size_t position = 0;
+
+    while (position < length && matches.size() < limit) {
+        // Every match starts with the literal prefix, if there is one
+        if (!literalPrefix.empty()) {
+            position = prefixSearch.find(text, length, position);
+            if (position >= length) break;
+        }
+
+        size_t end = matchEnd(text, length, position);
+        if (end == position) break;
+        size_t start = matchStart(text, position, end);
+
+        SearchMatch match;
+        match.length = end - start;
+        match.patternId = 0;
+        cursor.advanceTo(start, match);
+        matches.push_back(match);
+        position = end;
+    }
+
+    return matches;
+}
+
+std::vector<SearchMatch> Regex::findAll(const char* text, size_t length) {
+    return findMatches(text, length, (size_t)-1);
+}
+
+bool Regex::search(const char* text, size_t length) {
+    return !findMatches(text, length, 1).empty();
+}
@@ -0,0 +1,170 @@
+#ifndef REGEX_H
+#define REGEX_H
+
+#include <bitset>
+#include <cstddef>
+#include <map>
+#include <string>
+#include <vector>
+#include "TextEditorApi.h"
+
+// Regular expression search without backtracking.
+//
+// Supported syntax: literals, '.', [...] classes with ranges and negation,
+// \d \w \s (and \D \W \S), grouping, '|', '*', '+', '?', plus '^' at the very
+// start and '$' at the very end of the pattern (line anchors).
+//
+// The pattern is compiled to a Thompson NFA; DFA states are built lazily from
+// NFA state sets while scanning and kept in a bounded cache that is flushed
+// when full, so every scan is linear in the text it reads.
+class Regex {
+private:
+    typedef std::bitset<256> ByteSet;
+
+    enum NodeType {
+        NODE_EMPTY,
+        NODE_BYTES,
+        NODE_CONCAT,
+        NODE_ALTERNATE,
+        NODE_STAR,
+        NODE_PLUS,
+        NODE_QUEST
+    };
+
+    struct Node {
+        NodeType type;
+        int left;
+        int right;
+        int set;
+    };
+
+    enum NfaType {
+        NFA_BYTES,
+        NFA_SPLIT,
+        NFA_MATCH
+    };
+
+    struct NfaState {
+        NfaType type;
+        int out;
+        int out1;
+        int set;
+    };
+
+    struct Nfa {
+        std::vector<NfaState> states;
+        int start;
+    };
+
+    // Lazily built DFA over one NFA.
+    //
+    // An anchored DFA's states are the sets of NFA states reachable from the
+    // start. A search DFA finds where the leftmost-longest match ends in one
+    // pass: until something matches it starts a thread at every position,
+    // and it keeps the threads grouped by start position, earliest first,
+    // with an NFA state two groups share kept only in the earlier one. Once
+    // a group matches, the groups after it are dropped and no new threads
+    // start, so the DFA accepts exactly where the leftmost match found so far
+    // ends and dies once no longer or further-left match is possible.
+    class Dfa {
+    private:
+        // A search DFA's key lists each group's NFA states followed by MARK,
+        // then SAW_MATCH once a match has been found
+        enum KeyMarker { MARK = -1, SAW_MATCH = -2 };
+
+        struct State {
+            std::vector<int> key;
+            bool accepting;
+            int next[256];
+        };
+
+        const Nfa* nfa;
+        const std::vector<ByteSet>* sets;
+        bool searching;
+        bool lineStarts;   // search: threads start only at line starts
+        bool lineEnds;     // search: a match only counts if a newline follows
+        size_t maxStates;
+        std::vector<State> states;
+        std::map<std::vector<int>, int> index;
+        std::vector<int> startSet;
+        int midLineStart;
+        size_t flushes;
+
+        void setup(const Nfa* nfa, const std::vector<ByteSet>* sets, size_t maxStates);
+        void addClosure(int nfaState, std::vector<int>& output, std::vector<char>& seen) const;
+        void move(const std::vector<int>& current, unsigned char byte, std::vector<int>& output,
+                  std::vector<char>& seen) const;
+        void keepLeftmostMatch(std::vector<std::vector<int> >& groups, bool& sawMatch) const;
+        std::vector<int> searchStep(const std::vector<int>& key, unsigned char byte) const;
+        int intern(std::vector<int>& key);
+        void reset();
+
+    public:
+        Dfa();
+        void init(const Nfa* nfa, const std::vector<ByteSet>* sets, size_t maxStates);
+        void initSearch(const Nfa* nfa, const std::vector<ByteSet>* sets, bool lineStarts, bool lineEnds,
+                        size_t maxStates);
+
+        int start(bool atLineStart = true) const { return atLineStart ? 0 : midLineStart; }
+        bool isDead(int state) const { return state == 1; }
+        bool isAccepting(int state) const { return states[state].accepting; }
+        int step(int state, unsigned char byte);
+
+        size_t cachedStates() const { return states.size(); }
+        size_t cacheFlushes() const { return flushes; }
+    };
+
+    std::string pattern;
+    std::string errorMessage;
+    size_t position;
+    bool anchoredStart;
+    bool anchoredEnd;
+
+    std::vector<Node> nodes;
+    std::vector<ByteSet> sets;
+    int root;
+    std::string literalPrefix;
+
+    Nfa forwardNfa;
+    Nfa reverseNfa;
+    Dfa forward;
+    Dfa reverse;
+
+    // Parser
+    int addNode(NodeType type, int left, int right, int set);
+    int parseAlternation();
+    int parseConcat();
+    int parseRepeat();
+    int parseAtom();
+    bool parseClass(ByteSet& set);
+    bool parseEscape(ByteSet& set);
+    void extractPrefix(int node, bool& complete);
+
+    // NFA construction
+    int compile(Nfa& nfa, int node, bool reversed, std::vector<std::pair<int, int> >& dangling);
+    void patch(Nfa& nfa, const std::vector<std::pair<int, int> >& dangling, int target);
+    void buildNfa(Nfa& nfa, bool reversed);
+
+    bool isLineStart(const char* text, size_t offset) const;
+    size_t matchEnd(const char* text, size_t length, size_t from);
+    size_t matchStart(const char* text, size_t from, size_t end);
+    std::vector<SearchMatch> findMatches(const char* text, size_t length, size_t limit);
+
+public:
+    explicit Regex(const std::string& expression, size_t maxCachedStates = 2048);
+
+    bool isValid() const { return errorMessage.empty(); }
+    const std::string& error() const { return errorMessage; }
+
+    // Leftmost-longest, non-overlapping, non-empty matches
+    std::vector<SearchMatch> findAll(const char* text, size_t length);
+
+    // True if the text contains at least one non-empty match
+    bool search(const char* text, size_t length);
+
+private:
+    Regex(const Regex&);
+    Regex& operator=(const Regex&);
+};
+
+#endif // REGEX_H
@@ -0,0 +1,236 @@
+#ifndef TEXT_EDITOR_API_H
+#define TEXT_EDITOR_API_H
+
+#include <stddef.h>
+
+// C API of the texteditor library: the buffer, search, history, clipboard
+// and journal functions the interactive editor is built on, and the
+// headless editor* calls for other programs
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Basic text buffer structure
+// The text itself lives in a piece table (storage); content is a contiguous
+// copy that is only rebuilt by flattenBuffer when something needs it.
+typedef struct {
+    char* content;
+    size_t size;
+    size_t used;
+    void* storage;
+    int contentStale;
+} TextBuffer;
+
+// Undo history statistics
+typedef struct {
+    size_t undoEntries;
+    size_t redoEntries;
+    size_t compressedEntries;
+    size_t evictedEntries;
+    size_t storedBytes;         // memory held by the recorded edits
+    size_t compressedRawBytes;  // compressed entries, before compression
+    size_t compressedBytes;     // compressed entries, after compression
+    size_t budget;
+} HistoryStats;
+
+// Search match position
+typedef struct {
+    size_t offset;
+    size_t line;
+    size_t column;
+    size_t length;
+    size_t patternId;
+} SearchMatch;
+
+// Search results owned by the caller (release with freeSearchResults)
+typedef struct {
+    SearchMatch* matches;
+    size_t count;
+} SearchResults;
+
+// One edit of a batch (bufferApplyEdits): offsets refer to the text before
+// the batch; edits may come in any order but must not overlap. Inserts at
+// one offset keep their order, and all of them land before the text an
+// erase at that offset removes.
+typedef struct {
+    size_t offset;
+    size_t deleteLength;
+    const char* text;
+    size_t length;
+} BufferEdit;
+
+// Byte-for-byte rewrite of the whole text (bufferTransform): fills output
+// from input, both length bytes; returns 0, or -1 to leave the text alone
+typedef int (*BufferTransform)(const char* input, char* output, size_t length, void* context);
+
+// Read-only pass over the text in order (bufferVisitText): called once per
+// stored run; returns 0, or -1 to stop
+typedef int (*BufferVisitor)(const char* text, size_t length, void* context);
+
+// Totals of a manifest encryption run (editorEncryptManifest)
+typedef struct {
+    size_t files;       // written successfully
+    size_t failed;      // including malformed manifest lines
+    size_t bytes;
+    double seconds;
+} EncryptBatchStats;
+
+// Status codes of the headless editor API (editor* functions): zero or
+// positive when the call went through, negative when it did not
+typedef enum {
+    EDITOR_OK = 0,
+    EDITOR_NOTHING = 1,             // valid call with nothing to do (empty register, no undo...)
+    EDITOR_ERROR_ARGUMENT = -1,
+    EDITOR_ERROR_POSITION = -2,     // line/column outside the text
+    EDITOR_ERROR_IO = -3,
+    EDITOR_ERROR_CIPHER = -4,       // libcaesar not loaded or the transform failed
+    EDITOR_ERROR_MEMORY = -5
+} EditorStatus;
+
+// Data types for lines
+typedef enum {
+    DATA_TYPE_TEXT = 0,
+    DATA_TYPE_CONTACT = 1,
+    DATA_TYPE_CHECKLIST = 2
+} DataType;
+
+// Contact information structure
+typedef struct {
+    char name[100];
+    char surname[100];
+    char email[150];
+} ContactInfo;
+
+// Checklist item structure
+typedef struct {
+    char info[200];
+    int checked; // 0 = unchecked, 1 = checked
+} ChecklistItem;
+
+// Line data structure
+typedef struct {
+    DataType type;
+    union {
+        char* text;
+        ContactInfo contact;
+        ChecklistItem checklist;
+    } data;
+} LineData;
+
+// Document structure
+typedef struct {
+    LineData* lines;
+    size_t lineCount;
+    size_t capacity;
+} Document;
+
+// Buffer memory (the flattened copy of the text)
+void resizeBufferIfNeeded(TextBuffer* buffer, size_t additionalSpace);
+
+// Piece-table storage
+int initStorage(TextBuffer* buffer);
+void freeStorage(TextBuffer* buffer);
+int bufferInsert(TextBuffer* buffer, size_t position, const char* text, size_t length);
+int bufferErase(TextBuffer* buffer, size_t position, size_t length);
+int bufferAppend(TextBuffer* buffer, const char* text, size_t length);
+int bufferApplyEdits(TextBuffer* buffer, const BufferEdit* edits, size_t count);
+int bufferIngest(TextBuffer* buffer, int fd, size_t* bytesRead, double* seconds);
+int bufferAssign(TextBuffer* buffer, const char* text, size_t length);
+int bufferTransform(TextBuffer* buffer, BufferTransform transform, void* context);
+int bufferVisitText(TextBuffer* buffer, BufferVisitor visitor, void* context);
+int bufferLoadFile(TextBuffer* buffer, const char* path);
+int bufferSaveFile(TextBuffer* buffer, const char* path, size_t* bytesWritten, double* seconds);
+void flattenBuffer(TextBuffer* buffer);
+
+// Edit history (operation log kept by the storage layer). bufferCheckpoint
+// ends an undo step; while coalescing is on (the default), an edit that
+// continues the previous step, like typing on at its end, is merged into it.
+int bufferEnableHistory(TextBuffer* buffer);
+void bufferDisableHistory(TextBuffer* buffer);
+void bufferCheckpoint(TextBuffer* buffer);
+int bufferSetCoalescing(TextBuffer* buffer, int enabled);
+void bufferBeginTransaction(TextBuffer* buffer);
+void bufferCommitTransaction(TextBuffer* buffer);
+int bufferUndo(TextBuffer* buffer);
+int bufferRedo(TextBuffer* buffer);
+int bufferSetHistoryBudget(TextBuffer* buffer, size_t bytes);
+int bufferHistoryStats(TextBuffer* buffer, HistoryStats* stats);
+
+// Crash recovery journal (returns 1 when an unfinished session was recovered).
+// When opening fails, or succeeds with a new session because the last one
+// cannot be recovered, editorLastError says why. Writes happen in the background,
+// so a journal that stops working later is reported by bufferJournalFailed:
+// nonzero once a write failed, with the reason copied to message.
+int bufferOpenJournal(TextBuffer* buffer, const char* path, size_t* replayedEdits);
+void bufferCloseJournal(TextBuffer* buffer, int discard);
+int bufferJournalFailed(TextBuffer* buffer, char* message, size_t messageSize);
+
+// Clipboard shared by all buffers: registers 'a'..'z' and the kill ring
+// '0'..'9' ('0' is the newest copy); name 0 means the default. Paste and
+// info return 1 when the register is empty. clipboardIsRegister is nonzero
+// for a register name; writable leaves out the ring, which cannot be copied
+// into by name.
+int clipboardIsRegister(char name, int writable);
+int bufferCopyToRegister(TextBuffer* buffer, size_t position, size_t length, char name);
+int bufferPasteRegister(TextBuffer* buffer, size_t position, char name, size_t* length);
+int clipboardRegisterInfo(char name, size_t* length, int* isReference, char* preview, size_t previewSize);
+
+// Line index (O(log) lookups maintained by every edit)
+size_t bufferLineCount(TextBuffer* buffer);
+int bufferLineLength(TextBuffer* buffer, size_t line, size_t* length);
+int bufferLineToOffset(TextBuffer* buffer, size_t line, size_t column, size_t* offset);
+int bufferOffsetToLine(TextBuffer* buffer, size_t offset, size_t* line, size_t* column);
+
+// Search
+int searchBuffer(TextBuffer* buffer, const char* pattern, size_t length, SearchResults* results);
+int searchBufferMulti(TextBuffer* buffer, const char* const* patterns, const size_t* lengths,
+                      size_t patternCount, SearchResults* results);
+int searchBufferRegex(TextBuffer* buffer, const char* pattern, size_t length, SearchResults* results);
+int searchBufferParallel(TextBuffer* buffer, const char* pattern, size_t length, size_t threadCount,
+                         SearchResults* results);
+void freeSearchResults(SearchResults* results);
+
+// Headless editor API (libtexteditor): no prompts and no output, every
+// call returns an EditorStatus and every edit is one undo step. Lines and
+// columns count from 0. editorCreate sets up an empty buffer without
+// history, and with coalescing off so that no edit merges into the one
+// before; call bufferEnableHistory once the initial text is in place.
+int editorCreate(TextBuffer* buffer);
+void editorDestroy(TextBuffer* buffer);
+int editorText(TextBuffer* buffer, const char** text, size_t* length);
+int editorAppend(TextBuffer* buffer, const char* text, size_t length);
+int editorInsert(TextBuffer* buffer, size_t line, size_t column, const char* text, size_t length);
+int editorDelete(TextBuffer* buffer, size_t line, size_t column, size_t count, size_t* deleted);
+int editorReplace(TextBuffer* buffer, size_t line, size_t column, const char* text, size_t length);
+int editorCopy(TextBuffer* buffer, size_t line, size_t column, size_t count, char name, size_t* copied);
+int editorCut(TextBuffer* buffer, size_t line, size_t column, size_t count, char name, size_t* cut);
+int editorPaste(TextBuffer* buffer, size_t line, size_t column, char name, size_t* pasted);
+int editorSearch(TextBuffer* buffer, const char* pattern, size_t length, SearchResults* results);
+int editorSearchRegex(TextBuffer* buffer, const char* pattern, size_t length, SearchResults* results);
+int editorUndo(TextBuffer* buffer);
+int editorRedo(TextBuffer* buffer);
+int editorLoad(TextBuffer* buffer, const char* path);
+int editorSave(TextBuffer* buffer, const char* path, size_t* bytesWritten, double* seconds);
+int editorCipherReady(void);
+int editorEncrypt(TextBuffer* buffer, int key);
+int editorDecrypt(TextBuffer* buffer, int key);
+int editorEncryptFile(const char* inputPath, const char* outputPath, int key);
+int editorDecryptFile(const char* inputPath, const char* outputPath, int key);
+int editorEncryptFileParallel(const char* inputPath, const char* outputPath, int key, size_t threadCount);
+int editorDecryptFileParallel(const char* inputPath, const char* outputPath, int key, size_t threadCount);
+int editorEncryptManifest(const char* manifestPath, size_t ioThreads, EncryptBatchStats* stats);
+int editorSaveEncrypted(TextBuffer* buffer, const char* path, int key);
+int editorLoadEncrypted(TextBuffer* buffer, const char* path, int key);
+
+// The library prints nothing: a call that fails leaves the reason here, per
+// thread, as do bufferOpenJournal for a session it had to drop and
+// editorEncryptManifest for each failed job (one per line). Those two clear
+// it first; otherwise it is only meaningful right after a failure.
+const char* editorLastError(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TEXT_EDITOR_API_H
@@ -0,0 +1,75 @@
+#include "TextSearch.h"
+#include <cstring>
+
+LineCursor::LineCursor(const char* text, size_t startLine)
+    : text(text), position(0), line(startLine), lineStart(0) {
+}
+
+void LineCursor::advanceTo(size_t offset, SearchMatch& match) {
+    while (position < offset) {
+        const char* found = static_cast<const char*>(memchr(text + position, '\n', offset - position));
+        if (!found) break;
+        line++;
+        position = (found - text) + 1;
+        lineStart = position;
+    }
+    position = offset;
+
+    match.offset = offset;
+    match.line = line;
+    match.column = offset - lineStart;
+}
+
+TextSearch::TextSearch(const std::string& pattern) : pattern(pattern) {
+    size_t length = pattern.size();
+    for (int i = 0; i < 256; i++) {
+        skip[i] = length ? length : 1;
+    }
+    for (size_t i = 0; i + 1 < length; i++) {
+        skip[(unsigned char)pattern[i]] = length - 1 - i;
+    }
+}
+
+size_t TextSearch::find(const char* text, size_t length, size_t from) const {
+    size_t patternLength = pattern.size();
+    if (patternLength == 0 || patternLength > length) return length;
+
+    const unsigned char first = (unsigned char)pattern[0];
+    const unsigned char last = (unsigned char)pattern[patternLength - 1];
+    size_t limit = length - patternLength;
+    size_t position = from;
+
+    while (position <= limit) {
+        // Jump straight to the next window that starts with the right byte
+        const char* candidate = static_cast<const char*>(memchr(text + position, first, limit - position + 1));
+        if (!candidate) break;
+        position = candidate - text;
+
+        unsigned char tail = (unsigned char)text[position + patternLength - 1];
+        if (tail == last && memcmp(text + position, pattern.data(), patternLength - 1) == 0) {
+            return position;
+        }
+        position += skip[tail];
+    }
+
+    return length;
+}
+
+std::vector<SearchMatch> TextSearch::findAll(const char* text, size_t length) const {
+    std::vector<SearchMatch> matches;
+    if (!text || pattern.empty()) return matches;
+
+    LineCursor cursor(text);
+    size_t position = 0;
+
+    while ((position = find(text, length, position)) < length) {
+        SearchMatch match;
+        match.length = pattern.size();
+        match.patternId = 0;
+        cursor.advanceTo(position, match);
+        matches.push_back(match);
+        position += pattern.size();
+    }
+
+    return matches;
+}
@@ -0,0 +1,44 @@
+#ifndef TEXT_SEARCH_H
+#define TEXT_SEARCH_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "TextEditorApi.h"
+
+// Carries line/column counters forward while a scan moves through the text,
+// so reporting positions costs one pass in total instead of one per match.
+class LineCursor {
+private:
+    const char* text;
+    size_t position;
+    size_t line;
+    size_t lineStart;
+
+public:
+    LineCursor(const char* text, size_t startLine = 0);
+
+    // Move forward to offset (must not go backwards) and fill in line/column
+    void advanceTo(size_t offset, SearchMatch& match);
+};
+
+// Literal substring search: Boyer-Moore-Horspool shifts combined with a
+// memchr prefilter on the first byte, which libc vectorizes.
+class TextSearch {
+private:
+    std::string pattern;
+    size_t skip[256];
+
+public:
+    explicit TextSearch(const std::string& pattern);
+
+    // Offset of the next match at or after from, or length if none
+    size_t find(const char* text, size_t length, size_t from) const;
+
+    // Every non-overlapping match with line/column, in one pass
+    std::vector<SearchMatch> findAll(const char* text, size_t length) const;
+
+    size_t patternLength() const { return pattern.size(); }
+};
+
+#endif // TEXT_SEARCH_H
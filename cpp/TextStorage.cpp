@@ -0,0 +1,770 @@
+#include <string>
+#include <cstring>
+#include <cstdlib>
+#include <cstdio>
+#include <chrono>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cerrno>
+#include <algorithm>
+#include "PieceTable.h"
+#include "MappedFile.h"
+#include "AtomicFileWriter.h"
+#include "EditHistory.h"
+#include "EditJournal.h"
+#include "Clipboard.h"
+#include "TextSearch.h"
+#include "AhoCorasick.h"
+#include "Regex.h"
+#include "ParallelSearch.h"
+#include "EditorError.h"
+#include "TextEditorApi.h"
+
+// Bridge between the C TextBuffer and the piece table that owns the text.
+// Every edit goes through here so that buffer->used always matches the
+// piece table, while buffer->content is only refreshed on demand.
+//
+// buffer->content is read-only for callers: while the text is still the
+// untouched original buffer (e.g. a freshly mapped file), content points
+// straight at it instead of at a copy, and the buffer's own allocation is
+// parked in the storage state until the next edit.
+//
+// Once history is enabled, every edit is also recorded as an operation in
+// the buffer's EditHistory so it can be undone and redone, and once a
+// journal is open every change is logged there for crash recovery.
+
+struct StorageState {
+    PieceTable table;
+    char* ownedContent;
+    size_t ownedSize;
+    bool borrowed;
+    EditHistory* history;
+    bool coalescing;   // applied to the history whenever there is one
+    EditJournal* journal;
+};
+
+static StorageState* stateOf(TextBuffer* buffer) {
+    return buffer ? static_cast<StorageState*>(buffer->storage) : nullptr;
+}
+
+static PieceTable* storageOf(TextBuffer* buffer) {
+    StorageState* state = stateOf(buffer);
+    return state ? &state->table : nullptr;
+}
+
+// Point content back at the buffer's own allocation
+static void returnContent(TextBuffer* buffer, StorageState* state) {
+    if (!state->borrowed) return;
+
+    buffer->content = state->ownedContent;
+    buffer->size = state->ownedSize;
+    buffer->contentStale = 1;
+    state->ownedContent = nullptr;
+    state->ownedSize = 0;
+    state->borrowed = false;
+}
+
+// Shared by every buffer, like a system clipboard
+static Clipboard clipboard;
+
+// Erases at least this large are kept in the history as snapshots rather
+// than as a copy of the removed bytes
+static const size_t SNAPSHOT_ERASE_SIZE = 1 << 20;
+
+// The table changed: refresh used and drop the contiguous view
+static void contentChanged(TextBuffer* buffer, StorageState* state) {
+    buffer->used = state->table.length();
+    returnContent(buffer, state);
+    buffer->contentStale = 1;
+}
+
+// Hand the bytes an erase is about to remove to the history
+static void recordErase(StorageState* state, size_t position, size_t length) {
+    if (state->journal) {
+        state->journal->erased(position, length);
+    }
+    if (!state->history || length == 0) return;
+
+    std::string removed(length, '\0');
+    state->table.copyRange(position, length, &removed[0]);
+    state->history->recordErase(position, removed);
+}
+
+static void recordInsert(StorageState* state, size_t position, const char* text, size_t length) {
+    if (state->journal) {
+        state->journal->inserted(position, text, length);
+    }
+    if (state->history) {
+        state->history->recordInsert(position, text, length);
+    }
+}
+
+// The history keeps a large change as snapshots of both versions
+static void recordSnapshots(StorageState* state, const PieceTable::Snapshot& previous) {
+    if (state->history) {
+        state->history->recordReplace(previous, state->table.snapshot());
+    }
+}
+
+// Whole-text replacement: snapshots in the history, and a checkpoint in the
+// journal, which has no record for it
+static void recordReplaced(StorageState* state, const PieceTable::Snapshot& previous) {
+    if (state->journal) {
+        state->journal->restored();
+    }
+    recordSnapshots(state, previous);
+}
+
+static void checkpointIfDue(StorageState* state) {
+    if (state->journal && state->journal->checkpointDue(state->table.length())) {
+        state->journal->checkpoint(state->table);
+    }
+}
+
+// The text is now exactly the file at path, which the journal can refer to
+// instead of checkpointing a copy
+static void checkpointAsFile(StorageState* state, const char* path) {
+    if (state->journal) {
+        state->journal->checkpointFile(path, state->table);
+    }
+}
+
+extern "C" int initStorage(TextBuffer* buffer) {
+    if (!buffer) return -1;
+
+    StorageState* state = new StorageState();
+    state->table.reset(buffer->content, buffer->used);
+    state->ownedContent = nullptr;
+    state->ownedSize = 0;
+    state->borrowed = false;
+    state->history = nullptr;
+    state->coalescing = true;
+    state->journal = nullptr;
+
+    buffer->storage = state;
+    buffer->contentStale = 0;
+    return 0;
+}
+
+extern "C" void freeStorage(TextBuffer* buffer) {
+    StorageState* state = stateOf(buffer);
+    if (!state) return;
+
+    returnContent(buffer, state);
+    delete state->journal;
+    delete state->history;
+    delete state;
+    buffer->storage = nullptr;
+    buffer->contentStale = 0;
+}
+
+extern "C" int bufferInsert(TextBuffer* buffer, size_t position, const char* text, size_t length) {
+    StorageState* state = stateOf(buffer);
+    if (!state || position > buffer->used) return -1;
+
+    if (!state->table.insert(position, text, length)) return -1;
+    recordInsert(state, position, text, length);
+    checkpointIfDue(state);
+
+    buffer->used = state->table.length();
+    if (length > 0) {
+        returnContent(buffer, state);
+        buffer->contentStale = 1;
+    }
+    return 0;
+}
+
+extern "C" int bufferErase(TextBuffer* buffer, size_t position, size_t length) {
+    StorageState* state = stateOf(buffer);
+    if (!state || position > buffer->used) return -1;
+
+    if (length > buffer->used - position) {
+        length = buffer->used - position;
+    }
+    if (length >= SNAPSHOT_ERASE_SIZE) {
+        PieceTable::Snapshot previous = state->table.snapshot();
+        if (!state->table.erase(position, length)) return -1;
+        if (state->journal) {
+            state->journal->erased(position, length);
+        }
+        recordSnapshots(state, previous);
+    } else {
+        recordErase(state, position, length);
+        if (!state->table.erase(position, length)) return -1;
+    }
+    checkpointIfDue(state);
+
+    if (state->table.length() != buffer->used) {
+        buffer->used = state->table.length();
+        returnContent(buffer, state);
+        buffer->contentStale = 1;
+    }
+    return 0;
+}
+
+// Pure inserts sort before an erase at the same offset, so whether a batch
+// is valid does not depend on the order the caller listed it in
+static bool editBefore(const PieceTable::Edit& a, const PieceTable::Edit& b) {
+    if (a.offset != b.offset) return a.offset < b.offset;
+    return a.eraseLength == 0 && b.eraseLength > 0;
+}
+
+extern "C" int bufferApplyEdits(TextBuffer* buffer, const BufferEdit* edits, size_t count) {
+    StorageState* state = stateOf(buffer);
+    if (!state || (count > 0 && !edits)) return -1;
+
+    std::vector<PieceTable::Edit> sorted(count);
+    size_t erased = 0;
+    for (size_t i = 0; i < count; i++) {
+        sorted[i].offset = edits[i].offset;
+        sorted[i].eraseLength = edits[i].deleteLength;
+        sorted[i].text = edits[i].text;
+        sorted[i].length = edits[i].text ? edits[i].length : 0;
+        erased += edits[i].deleteLength;
+    }
+    // Stable, so inserts at the same offset keep the caller's order
+    std::stable_sort(sorted.begin(), sorted.end(), editBefore);
+
+    size_t total = state->table.length();
+    size_t end = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (sorted[i].offset < end || sorted[i].offset > total || sorted[i].eraseLength > total - sorted[i].offset) {
+            return -1;
+        }
+        end = sorted[i].offset + sorted[i].eraseLength;
+    }
+    if (count == 0) return 0;
+
+    // Everything lands in one undo entry. The log sees the edits applied in
+    // order, so each position is shifted by what the earlier ones changed.
+    if (state->history) state->history->beginTransaction();
+
+    // Large erases go into the history as snapshots instead
+    PieceTable::Snapshot previous;
+    bool asSnapshot = erased >= SNAPSHOT_ERASE_SIZE;
+    if (asSnapshot) {
+        previous = state->table.snapshot();
+    }
+
+    size_t shift = 0;
+    for (size_t i = 0; i < count; i++) {
+        const PieceTable::Edit& edit = sorted[i];
+        size_t position = edit.offset + shift;
+        if (state->journal) {
+            state->journal->erased(position, edit.eraseLength);
+            state->journal->inserted(position, edit.text, edit.length);
+        }
+        if (state->history && !asSnapshot) {
+            if (edit.eraseLength > 0) {
+                std::string removed(edit.eraseLength, '\0');
+                state->table.copyRange(edit.offset, edit.eraseLength, &removed[0]);
+                state->history->recordErase(position, removed);
+            }
+            state->history->recordInsert(position, edit.text, edit.length);
+        }
+        shift = shift + edit.length - edit.eraseLength;
+    }
+
+    bool applied = state->table.applyEdits(sorted);
+    if (applied && asSnapshot) {
+        recordSnapshots(state, previous);
+    }
+    if (state->history) state->history->commitTransaction();
+    if (!applied) return -1;
+
+    checkpointIfDue(state);
+    contentChanged(buffer, state);
+    return 0;
+}
+
+extern "C" int bufferAppend(TextBuffer* buffer, const char* text, size_t length) {
+    StorageState* state = stateOf(buffer);
+    if (!state) return -1;
+
+    size_t position = state->table.length();
+    if (!state->table.append(text, length)) return -1;
+    recordInsert(state, position, text, length);
+    checkpointIfDue(state);
+
+    buffer->used = state->table.length();
+    if (length > 0) {
+        returnContent(buffer, state);
+        buffer->contentStale = 1;
+    }
+    return 0;
+}
+
+extern "C" int bufferIngest(TextBuffer* buffer, int fd, size_t* bytesRead, double* seconds) {
+    StorageState* state = stateOf(buffer);
+    if (!state || fd < 0) return -1;
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    // Regular files tell us how much is coming; pipes just grow geometrically
+    struct stat info;
+    if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0) {
+        state->table.reserveAppend((size_t)info.st_size);
+    }
+
+    std::vector<char> block(1 << 20);
+    size_t total = 0;
+    bool failed = false;
+    for (;;) {
+        ssize_t count = read(fd, block.data(), block.size());
+        if (count < 0) {
+            if (errno == EINTR) continue;
+            failed = true;
+            break;
+        }
+        if (count == 0) break;
+
+        recordInsert(state, state->table.length(), block.data(), (size_t)count);
+        state->table.append(block.data(), (size_t)count);
+        checkpointIfDue(state);
+        total += (size_t)count;
+    }
+
+    buffer->used = state->table.length();
+    if (total > 0) {
+        returnContent(buffer, state);
+        buffer->contentStale = 1;
+    }
+    if (bytesRead) {
+        *bytesRead = total;
+    }
+    if (seconds) {
+        *seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+    return failed ? -1 : 0;
+}
+
+extern "C" int bufferAssign(TextBuffer* buffer, const char* text, size_t length) {
+    StorageState* state = stateOf(buffer);
+    if (!state) return -1;
+
+    PieceTable::Snapshot previous = state->table.snapshot();
+
+    // The table copies text before anything it may point into goes away;
+    // content then simply borrows the new original buffer.
+    state->table.reset(text, length);
+    recordReplaced(state, previous);
+    checkpointIfDue(state);
+    returnContent(buffer, state);
+    buffer->used = state->table.length();
+    buffer->contentStale = 1;
+    return 0;
+}
+
+// The transform reads the current text where it lies (content when that is
+// up to date, which may be a read-only mapping, otherwise the pieces) and
+// writes the result straight into the string that becomes the new original
+// buffer, so the text is copied once and nothing is ever written through
+// content.
+extern "C" int bufferTransform(TextBuffer* buffer, BufferTransform transform, void* context) {
+    StorageState* state = stateOf(buffer);
+    if (!state || !transform) return -1;
+
+    size_t length = state->table.length();
+    std::string result(length, '\0');
+    if (!buffer->contentStale) {
+        if (transform(buffer->content, &result[0], length, context) != 0) return -1;
+    } else {
+        std::vector<std::pair<const char*, size_t> > pieces;
+        state->table.segments(pieces);
+
+        size_t offset = 0;
+        for (size_t i = 0; i < pieces.size(); i++) {
+            if (transform(pieces[i].first, &result[offset], pieces[i].second, context) != 0) return -1;
+            offset += pieces[i].second;
+        }
+    }
+
+    PieceTable::Snapshot previous = state->table.snapshot();
+    state->table.reset(result);
+    recordReplaced(state, previous);
+    checkpointIfDue(state);
+    returnContent(buffer, state);
+    buffer->used = state->table.length();
+    buffer->contentStale = 1;
+    return 0;
+}
+
+extern "C" int bufferVisitText(TextBuffer* buffer, BufferVisitor visitor, void* context) {
+    StorageState* state = stateOf(buffer);
+    if (!state || !visitor) return -1;
+
+    if (!buffer->contentStale) {
+        return buffer->used == 0 || visitor(buffer->content, buffer->used, context) == 0 ? 0 : -1;
+    }
+
+    std::vector<std::pair<const char*, size_t> > pieces;
+    state->table.segments(pieces);
+    for (size_t i = 0; i < pieces.size(); i++) {
+        if (visitor(pieces[i].first, pieces[i].second, context) != 0) return -1;
+    }
+    return 0;
+}
+
+extern "C" int bufferLoadFile(TextBuffer* buffer, const char* path) {
+    StorageState* state = stateOf(buffer);
+    if (!state || !path) return -1;
+
+    PieceTable::Snapshot previous = state->table.snapshot();
+
+    MappedFile* mapping = new MappedFile();
+    if (mapping->open(path)) {
+        state->table.reset(mapping);
+    } else {
+        delete mapping;
+
+        // Pipes, devices and empty files: read them in large blocks
+        FILE* file = fopen(path, "rb");
+        if (!file) return -1;
+
+        std::string text;
+        std::vector<char> block(1 << 16);
+        size_t count;
+        while ((count = fread(block.data(), 1, block.size(), file)) > 0) {
+            text.append(block.data(), count);
+        }
+        bool failed = ferror(file) != 0;
+        fclose(file);
+        if (failed) return -1;
+
+        state->table.reset(text);
+    }
+    recordReplaced(state, previous);
+    checkpointAsFile(state, path);
+
+    returnContent(buffer, state);
+    buffer->used = state->table.length();
+    buffer->contentStale = 1;
+    return 0;
+}
+
+extern "C" int bufferEnableHistory(TextBuffer* buffer) {
+    StorageState* state = stateOf(buffer);
+    if (!state) return -1;
+
+    if (state->history) {
+        state->history->clear();
+    } else {
+        state->history = new EditHistory();
+    }
+    state->history->setCoalescing(state->coalescing);
+    return 0;
+}
+
+extern "C" void bufferDisableHistory(TextBuffer* buffer) {
+    StorageState* state = stateOf(buffer);
+    if (!state) return;
+
+    delete state->history;
+    state->history = nullptr;
+}
+
+extern "C" int bufferSetCoalescing(TextBuffer* buffer, int enabled) {
+    StorageState* state = stateOf(buffer);
+    if (!state) return -1;
+
+    state->coalescing = enabled != 0;
+    if (state->history) {
+        state->history->setCoalescing(state->coalescing);
+    }
+    return 0;
+}
+
+extern "C" void bufferCheckpoint(TextBuffer* buffer) {
+    StorageState* state = stateOf(buffer);
+    if (state && state->history) {
+        state->history->checkpoint();
+    }
+}
+
+extern "C" void bufferBeginTransaction(TextBuffer* buffer) {
+    StorageState* state = stateOf(buffer);
+    if (state && state->history) {
+        state->history->beginTransaction();
+    }
+}
+
+extern "C" void bufferCommitTransaction(TextBuffer* buffer) {
+    StorageState* state = stateOf(buffer);
+    if (state && state->history) {
+        state->history->commitTransaction();
+    }
+}
+
+extern "C" int bufferUndo(TextBuffer* buffer) {
+    StorageState* state = stateOf(buffer);
+    if (!state || !state->history) return -1;
+
+    if (!state->history->undo(state->table, state->journal)) return 1;
+    checkpointIfDue(state);
+    contentChanged(buffer, state);
+    return 0;
+}
+
+extern "C" int bufferRedo(TextBuffer* buffer) {
+    StorageState* state = stateOf(buffer);
+    if (!state || !state->history) return -1;
+
+    if (!state->history->redo(state->table, state->journal)) return 1;
+    checkpointIfDue(state);
+    contentChanged(buffer, state);
+    return 0;
+}
+
+extern "C" int bufferOpenJournal(TextBuffer* buffer, const char* path, size_t* replayedEdits) {
+    StorageState* state = stateOf(buffer);
+    if (!state || !path || state->journal) return -1;
+
+    clearEditorError();
+    EditJournal* journal = new EditJournal();
+    size_t replayed = 0;
+    if (!journal->open(path, state->table, replayed)) {
+        delete journal;
+        return -1;
+    }
+    state->journal = journal;
+
+    if (replayedEdits) {
+        *replayedEdits = replayed;
+    }
+    if (!journal->recovered()) return 0;
+
+    // The table now holds the recovered session, which has no undo history
+    if (state->history) {
+        state->history->clear();
+    }
+    contentChanged(buffer, state);
+    return 1;
+}
+
+extern "C" void bufferCloseJournal(TextBuffer* buffer, int discard) {
+    StorageState* state = stateOf(buffer);
+    if (!state || !state->journal) return;
+
+    state->journal->close(discard != 0);
+    delete state->journal;
+    state->journal = nullptr;
+}
+
+extern "C" int bufferJournalFailed(TextBuffer* buffer, char* message, size_t messageSize) {
+    StorageState* state = stateOf(buffer);
+    std::string failure;
+    if (!state || !state->journal || !state->journal->failure(failure)) return 0;
+
+    if (message && messageSize > 0) {
+        size_t length = std::min(failure.size(), messageSize - 1);
+        memcpy(message, failure.data(), length);
+        message[length] = '\0';
+    }
+    return 1;
+}
+
+extern "C" int bufferSetHistoryBudget(TextBuffer* buffer, size_t bytes) {
+    StorageState* state = stateOf(buffer);
+    if (!state || !state->history) return -1;
+
+    state->history->setBudget(bytes);
+    return 0;
+}
+
+extern "C" int bufferHistoryStats(TextBuffer* buffer, HistoryStats* stats) {
+    StorageState* state = stateOf(buffer);
+    if (!state || !state->history || !stats) return -1;
+
+    state->history->statistics(*stats);
+    return 0;
+}
+
+extern "C" int clipboardIsRegister(char name, int writable) {
+    return (writable ? Clipboard::isNamedRegister(name) : Clipboard::isRegister(name)) ? 1 : 0;
+}
+
+extern "C" int bufferCopyToRegister(TextBuffer* buffer, size_t position, size_t length, char name) {
+    StorageState* state = stateOf(buffer);
+    if (!state) return -1;
+
+    return clipboard.copy(state->table, position, length, name) ? 0 : -1;
+}
+
+extern "C" int bufferPasteRegister(TextBuffer* buffer, size_t position, char name, size_t* length) {
+    const Clipboard::Clip* clip = clipboard.find(name);
+    if (!clip) return 1;
+
+    std::string text(clip->length(), '\0');
+    clip->read(0, text.size(), &text[0]);
+    if (bufferInsert(buffer, position, text.data(), text.size()) != 0) return -1;
+
+    if (length) *length = text.size();
+    return 0;
+}
+
+extern "C" int clipboardRegisterInfo(char name, size_t* length, int* isReference, char* preview, size_t previewSize) {
+    const Clipboard::Clip* clip = clipboard.find(name);
+    if (!clip) return 1;
+
+    if (length) *length = clip->length();
+    if (isReference) *isReference = clip->isReference() ? 1 : 0;
+    if (preview && previewSize > 0) {
+        size_t shown = clip->length() < previewSize - 1 ? clip->length() : previewSize - 1;
+        clip->read(0, shown, preview);
+        preview[shown] = '\0';
+    }
+    return 0;
+}
+
+extern "C" int bufferSaveFile(TextBuffer* buffer, const char* path, size_t* bytesWritten, double* seconds) {
+    StorageState* state = stateOf(buffer);
+    if (!state || !path) return -1;
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    // Write the pieces straight from the piece table, no flattening
+    std::vector<AtomicFileWriter::Segment> segments;
+    state->table.segments(segments);
+
+    AtomicFileWriter writer(path);
+    if (!writer.open() || !writer.write(segments) || !writer.commit()) return -1;
+    checkpointAsFile(state, path);
+
+    if (bytesWritten) {
+        *bytesWritten = writer.bytesWritten();
+    }
+    if (seconds) {
+        *seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+    return 0;
+}
+
+extern "C" void flattenBuffer(TextBuffer* buffer) {
+    StorageState* state = stateOf(buffer);
+    if (!state || !buffer->contentStale) return;
+
+    // Untouched original text needs no copy at all
+    const char* view = state->table.originalView();
+    if (view) {
+        if (!state->borrowed) {
+            state->ownedContent = buffer->content;
+            state->ownedSize = buffer->size;
+            state->borrowed = true;
+        }
+        buffer->content = const_cast<char*>(view);
+        buffer->size = buffer->used + 1;
+        buffer->contentStale = 0;
+        return;
+    }
+
+    returnContent(buffer, state);
+    resizeBufferIfNeeded(buffer, 0);
+    if (buffer->size < buffer->used + 1) {
+        setEditorError("Could not allocate contiguous view of the text.");
+        return;
+    }
+
+    state->table.copyTo(buffer->content);
+    buffer->content[buffer->used] = '\0';
+    buffer->contentStale = 0;
+}
+
+extern "C" size_t bufferLineCount(TextBuffer* buffer) {
+    PieceTable* table = storageOf(buffer);
+    return table ? table->lineCount() : 0;
+}
+
+extern "C" int bufferLineLength(TextBuffer* buffer, size_t line, size_t* length) {
+    PieceTable* table = storageOf(buffer);
+    if (!table || !length) return -1;
+
+    return table->lineLength(line, *length) ? 0 : -1;
+}
+
+extern "C" int bufferLineToOffset(TextBuffer* buffer, size_t line, size_t column, size_t* offset) {
+    PieceTable* table = storageOf(buffer);
+    if (!table || !offset) return -1;
+
+    size_t start, length;
+    if (!table->lineStart(line, start) || !table->lineLength(line, length)) return -1;
+    if (column > length) return -1;
+
+    *offset = start + column;
+    return 0;
+}
+
+extern "C" int bufferOffsetToLine(TextBuffer* buffer, size_t offset, size_t* line, size_t* column) {
+    PieceTable* table = storageOf(buffer);
+    if (!table || !line || !column) return -1;
+
+    return table->positionOf(offset, *line, *column) ? 0 : -1;
+}
+
+static int exportMatches(const std::vector<SearchMatch>& found, SearchResults* results) {
+    results->matches = nullptr;
+    results->count = 0;
+    if (found.empty()) return 0;
+
+    results->matches = (SearchMatch*)malloc(found.size() * sizeof(SearchMatch));
+    if (!results->matches) return -1;
+
+    memcpy(results->matches, found.data(), found.size() * sizeof(SearchMatch));
+    results->count = found.size();
+    return 0;
+}
+
+extern "C" int searchBuffer(TextBuffer* buffer, const char* pattern, size_t length, SearchResults* results) {
+    if (!buffer || !pattern || !results || length == 0) return -1;
+
+    flattenBuffer(buffer);
+    if (buffer->contentStale) return -1;
+    TextSearch search(std::string(pattern, length));
+    return exportMatches(search.findAll(buffer->content, buffer->used), results);
+}
+
+extern "C" int searchBufferMulti(TextBuffer* buffer, const char* const* patterns, const size_t* lengths,
+                                 size_t patternCount, SearchResults* results) {
+    if (!buffer || !patterns || !lengths || !results || patternCount == 0) return -1;
+
+    std::vector<std::string> patternSet;
+    patternSet.reserve(patternCount);
+    for (size_t i = 0; i < patternCount; i++) {
+        patternSet.push_back(std::string(patterns[i], lengths[i]));
+    }
+
+    flattenBuffer(buffer);
+    if (buffer->contentStale) return -1;
+    AhoCorasick automaton(patternSet);
+    return exportMatches(automaton.findAll(buffer->content, buffer->used), results);
+}
+
+extern "C" int searchBufferRegex(TextBuffer* buffer, const char* pattern, size_t length, SearchResults* results) {
+    if (!buffer || !pattern || !results) return -1;
+
+    Regex regex(std::string(pattern, length));
+    if (!regex.isValid()) {
+        setEditorError("Regex error: " + regex.error());
+        return -1;
+    }
+
+    flattenBuffer(buffer);
+    if (buffer->contentStale) return -1;
+    return exportMatches(regex.findAll(buffer->content, buffer->used), results);
+}
+
+extern "C" int searchBufferParallel(TextBuffer* buffer, const char* pattern, size_t length, size_t threadCount,
+                                    SearchResults* results) {
+    if (!buffer || !pattern || !results || length == 0) return -1;
+
+    flattenBuffer(buffer);
+    if (buffer->contentStale) return -1;
+    ParallelSearch search(std::string(pattern, length), threadCount);
+    return exportMatches(search.findAll(buffer->content, buffer->used), results);
+}
+
+extern "C" void freeSearchResults(SearchResults* results) {
+    if (!results) return;
+    free(results->matches);
+    results->matches = nullptr;
+    results->count = 0;
+}
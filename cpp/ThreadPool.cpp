@@ -0,0 +1,71 @@
+#include "ThreadPool.h"
+
+ThreadPool::ThreadPool(size_t threadCount) : running(0), stopping(false) {
+    if (threadCount == 0) {
+        threadCount = hardwareThreads();
+    }
+
+    workers.reserve(threadCount);
+    for (size_t i = 0; i < threadCount; i++) {
+        workers.push_back(std::thread(&ThreadPool::workerLoop, this));
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    taskReady.notify_all();
+
+    for (size_t i = 0; i < workers.size(); i++) {
+        workers[i].join();
+    }
+}
+
+size_t ThreadPool::hardwareThreads() {
+    unsigned int count = std::thread::hardware_concurrency();
+    return count ? count : 1;
+}
+
+void ThreadPool::submit(const std::function<void()>& task) {
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        tasks.push_back(task);
+    }
+    taskReady.notify_one();
+}
+
+void ThreadPool::wait() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (!tasks.empty() || running > 0) {
+        allDone.wait(lock);
+    }
+}
+
+void ThreadPool::workerLoop() {
+    for (;;) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            while (!stopping && tasks.empty()) {
+                taskReady.wait(lock);
+            }
+            if (stopping && tasks.empty()) return;
+
+            task = tasks.front();
+            tasks.pop_front();
+            running++;
+        }
+
+        task();
+
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            running--;
+            if (tasks.empty() && running == 0) {
+                allDone.notify_all();
+            }
+        }
+    }
+}
@@ -0,0 +1,44 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed-size pool of worker threads draining a shared task queue.
+class ThreadPool {
+private:
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()> > tasks;
+    std::mutex mutex;
+    std::condition_variable taskReady;
+    std::condition_variable allDone;
+    size_t running;
+    bool stopping;
+
+    void workerLoop();
+
+public:
+    // threadCount 0 means one thread per hardware core
+    explicit ThreadPool(size_t threadCount = 0);
+    ~ThreadPool();
+
+    void submit(const std::function<void()>& task);
+
+    // Block until every submitted task has finished
+    void wait();
+
+    size_t size() const { return workers.size(); }
+
+    static size_t hardwareThreads();
+
+private:
+    ThreadPool(const ThreadPool&);
+    ThreadPool& operator=(const ThreadPool&);
+};
+
+#endif // THREAD_POOL_H
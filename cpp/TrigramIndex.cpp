@@ -0,0 +1,180 @@
+#include "TrigramIndex.h"
+#include <algorithm>
+#include <iterator>
+
+static unsigned int trigramAt(const std::string& text, size_t i) {
+    return ((unsigned int)(unsigned char)text[i] << 16) |
+           ((unsigned int)(unsigned char)text[i + 1] << 8) |
+           (unsigned int)(unsigned char)text[i + 2];
+}
+
+TrigramIndex::TrigramIndex() : livePostings(0), stalePostings(0), retiredIds(0) {
+}
+
+void TrigramIndex::collectTrigrams(const std::string& text, std::vector<unsigned int>& trigrams) {
+    for (size_t i = 0; i + 3 <= text.size(); i++) {
+        trigrams.push_back(trigramAt(text, i));
+    }
+}
+
+void TrigramIndex::collectTrigrams(const std::vector<std::string>& fields, std::vector<unsigned int>& trigrams) {
+    // Fields are indexed separately so no trigram spans two of them
+    for (size_t i = 0; i < fields.size(); i++) {
+        collectTrigrams(fields[i], trigrams);
+    }
+    std::sort(trigrams.begin(), trigrams.end());
+    trigrams.erase(std::unique(trigrams.begin(), trigrams.end()), trigrams.end());
+}
+
+TrigramIndex::LineId TrigramIndex::addId(size_t position, const std::vector<std::string>& fields) {
+    LineId id = (LineId)idPositions.size();
+    std::vector<unsigned int> trigrams;
+    collectTrigrams(fields, trigrams);
+    idPositions.push_back(position);
+    idTrigramCounts.push_back(trigrams.size());
+
+    // New ids are the largest, so appending keeps every posting list sorted
+    for (size_t i = 0; i < trigrams.size(); i++) {
+        postings[trigrams[i]].push_back(id);
+    }
+    livePostings += trigrams.size();
+    return id;
+}
+
+void TrigramIndex::retireId(LineId id) {
+    idPositions[id] = NO_LINE;
+    livePostings -= idTrigramCounts[id];
+    stalePostings += idTrigramCounts[id];
+    idTrigramCounts[id] = 0;
+    retiredIds++;
+}
+
+void TrigramIndex::compactIfDue() {
+    if ((stalePostings > livePostings && stalePostings > 4096) ||
+        (retiredIds > lineIds.size() && retiredIds > 4096)) {
+        compact();
+    }
+}
+
+void TrigramIndex::compact() {
+    // Number the live ids in their current order, so the renumbered posting
+    // lists stay sorted
+    std::vector<LineId> newIds(idPositions.size(), (LineId)NO_ID);
+    LineId next = 0;
+    for (size_t id = 0; id < idPositions.size(); id++) {
+        if (idPositions[id] != NO_LINE) {
+            newIds[id] = next;
+            idPositions[next] = idPositions[id];
+            idTrigramCounts[next] = idTrigramCounts[id];
+            next++;
+        }
+    }
+    idPositions.resize(next);
+    idTrigramCounts.resize(next);
+    for (size_t i = 0; i < lineIds.size(); i++) {
+        lineIds[i] = newIds[lineIds[i]];
+    }
+
+    std::unordered_map<unsigned int, std::vector<LineId> >::iterator it = postings.begin();
+    while (it != postings.end()) {
+        std::vector<LineId>& list = it->second;
+        size_t kept = 0;
+        for (size_t i = 0; i < list.size(); i++) {
+            if (newIds[list[i]] != NO_ID) {
+                list[kept++] = newIds[list[i]];
+            }
+        }
+        list.resize(kept);
+
+        if (list.empty()) {
+            it = postings.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    stalePostings = 0;
+    retiredIds = 0;
+}
+
+void TrigramIndex::clear() {
+    postings.clear();
+    lineIds.clear();
+    idPositions.clear();
+    idTrigramCounts.clear();
+    livePostings = 0;
+    stalePostings = 0;
+    retiredIds = 0;
+}
+
+void TrigramIndex::appendLine(const std::vector<std::string>& fields) {
+    lineIds.push_back(addId(lineIds.size(), fields));
+}
+
+void TrigramIndex::updateLine(size_t position, const std::vector<std::string>& fields) {
+    if (position >= lineIds.size()) return;
+
+    retireId(lineIds[position]);
+    lineIds[position] = addId(position, fields);
+    compactIfDue();
+}
+
+void TrigramIndex::insertLine(size_t position, const std::vector<std::string>& fields) {
+    if (position > lineIds.size()) return;
+
+    lineIds.insert(lineIds.begin() + position, addId(position, fields));
+    for (size_t i = position + 1; i < lineIds.size(); i++) {
+        idPositions[lineIds[i]] = i;
+    }
+}
+
+void TrigramIndex::eraseLine(size_t position) {
+    if (position >= lineIds.size()) return;
+
+    retireId(lineIds[position]);
+    lineIds.erase(lineIds.begin() + position);
+    for (size_t i = position; i < lineIds.size(); i++) {
+        idPositions[lineIds[i]] = i;
+    }
+    compactIfDue();
+}
+
+bool TrigramIndex::candidates(const std::string& query, std::vector<size_t>& lines) const {
+    lines.clear();
+    if (query.size() < 3) return false;
+
+    std::vector<unsigned int> trigrams;
+    collectTrigrams(query, trigrams);
+    std::sort(trigrams.begin(), trigrams.end());
+    trigrams.erase(std::unique(trigrams.begin(), trigrams.end()), trigrams.end());
+
+    // Intersect starting from the shortest posting list
+    std::vector<const std::vector<LineId>*> lists;
+    for (size_t i = 0; i < trigrams.size(); i++) {
+        std::unordered_map<unsigned int, std::vector<LineId> >::const_iterator found = postings.find(trigrams[i]);
+        if (found == postings.end()) return true;
+        lists.push_back(&found->second);
+    }
+    std::sort(lists.begin(), lists.end(),
+              [](const std::vector<LineId>* a, const std::vector<LineId>* b) { return a->size() < b->size(); });
+
+    std::vector<LineId> current;
+    for (size_t i = 0; i < lists[0]->size(); i++) {
+        if (idPositions[(*lists[0])[i]] != NO_LINE) {
+            current.push_back((*lists[0])[i]);
+        }
+    }
+
+    std::vector<LineId> next;
+    for (size_t i = 1; i < lists.size() && !current.empty(); i++) {
+        next.clear();
+        std::set_intersection(current.begin(), current.end(), lists[i]->begin(), lists[i]->end(),
+                              std::back_inserter(next));
+        current.swap(next);
+    }
+
+    for (size_t i = 0; i < current.size(); i++) {
+        lines.push_back(idPositions[current[i]]);
+    }
+    std::sort(lines.begin(), lines.end());
+    return true;
+}
@@ -0,0 +1,54 @@
+#ifndef TRIGRAM_INDEX_H
+#define TRIGRAM_INDEX_H
+
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Inverted index from byte trigrams to the lines that contain them.
+//
+// Postings hold stable line ids rather than positions, so deleting a line
+// only touches the id <-> position tables. Editing a line retires its old id
+// (its postings go stale and are skipped) and indexes the new text under a
+// fresh id. Once stale postings outnumber the live ones, or retired ids the
+// lines, a compaction purges the stale postings and renumbers the live ids
+// from 0, which frees the retired ids for reuse.
+class TrigramIndex {
+private:
+    typedef unsigned int LineId;
+    static const size_t NO_LINE = (size_t)-1;
+    static const LineId NO_ID = (LineId)-1;
+
+    std::unordered_map<unsigned int, std::vector<LineId> > postings;
+    std::vector<LineId> lineIds;         // position -> id
+    std::vector<size_t> idPositions;     // id -> position, NO_LINE if retired
+    std::vector<size_t> idTrigramCounts;  // id -> postings it has
+    size_t livePostings;
+    size_t stalePostings;
+    size_t retiredIds;
+
+    static void collectTrigrams(const std::string& text, std::vector<unsigned int>& trigrams);
+    static void collectTrigrams(const std::vector<std::string>& fields, std::vector<unsigned int>& trigrams);
+    LineId addId(size_t position, const std::vector<std::string>& fields);
+    void retireId(LineId id);
+    void compactIfDue();
+    void compact();
+
+public:
+    TrigramIndex();
+
+    void clear();
+    void appendLine(const std::vector<std::string>& fields);
+    void updateLine(size_t position, const std::vector<std::string>& fields);
+    void insertLine(size_t position, const std::vector<std::string>& fields);
+    void eraseLine(size_t position);
+
+    // Sorted positions of lines holding every trigram of query. Returns false
+    // when the query is shorter than a trigram and the caller must scan.
+    bool candidates(const std::string& query, std::vector<size_t>& lines) const;
+
+    size_t lineCount() const { return lineIds.size(); }
+};
+
+#endif // TRIGRAM_INDEX_H
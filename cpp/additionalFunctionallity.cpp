@@ -4,124 +4,65 @@
 #include "../main.h"
 
 
-#define MIN(a,b) ((a)<(b)?(a):(b))
-#define MAX(a,b) ((a)>(b)?(a):(b))
-
-UndoRedoHistory history;
-char clipboard[1024] = {0};
-
-extern "C" void initHistory(void) {
-    for(int i = 0; i < 10; i++) {
-        history.states[i] = NULL;
-        history.stateSizes[i] = 0;
-    }
-    history.currentIndex = -1;
-    history.totalStates = 0;
+// Edits are recorded by the storage layer as they happen; saveState only
+// marks where one undoable command ends and the next begins. Edits that just
+// continue the previous command are merged into its entry, and a command that
+// makes several edits applies them in one editor call so it undoes in one step.
+
+extern "C" void initHistory(TextBuffer* buffer) {
+    bufferEnableHistory(buffer);
+    bufferSetCoalescing(buffer, 1);
 }
 
 extern "C" void saveState(TextBuffer* buffer) {
-    if (!buffer || !buffer->content) return;
-
-    history.currentIndex = (history.currentIndex + 1) % 10;
-
-    if (history.states[history.currentIndex] != NULL) {
-        free(history.states[history.currentIndex]);
-    }
-
-    history.stateSizes[history.currentIndex] = buffer->used + 1;
-    history.states[history.currentIndex] = (char*)malloc(history.stateSizes[history.currentIndex]);
-
-    if (history.states[history.currentIndex] != NULL) {
-        strncpy(history.states[history.currentIndex], buffer->content, buffer->used);
-        history.states[history.currentIndex][buffer->used] = '\0';
-
-        if (history.totalStates < 10) {
-            history.totalStates++;
-        }
-    }
+    bufferCheckpoint(buffer);
 }
 
 extern "C" void undoCommand(TextBuffer* buffer) {
-    if (history.totalStates <= 1) {
-        std::cout << "Nothing to undo." << std::endl;
-        return;
-    }
-
-    int prevIndex = (history.currentIndex - 1 + 10) % 10;
-
-    if (history.states[prevIndex] != NULL) {
-        strncpy(buffer->content, history.states[prevIndex], buffer->size - 1);
-        buffer->content[buffer->size - 1] = '\0';
-        buffer->used = strlen(buffer->content);
-
-        history.currentIndex = prevIndex;
-        history.totalStates--;
+    int status = editorUndo(buffer);
 
+    if (status == EDITOR_OK) {
         std::cout << "Undo completed." << std::endl;
+    } else if (status == EDITOR_NOTHING) {
+        std::cout << "Nothing to undo." << std::endl;
     } else {
-        std::cout << "Cannot undo - previous state not available." << std::endl;
+        std::cout << "Cannot undo - history is not available." << std::endl;
     }
 }
 
 extern "C" void redoCommand(TextBuffer* buffer) {
-    int nextIndex = (history.currentIndex + 1) % 10;
-
-    if (history.states[nextIndex] != NULL && history.totalStates < 10) {
-        strncpy(buffer->content, history.states[nextIndex], buffer->size - 1);
-        buffer->content[buffer->size - 1] = '\0';
-        buffer->used = strlen(buffer->content);
-
-        history.currentIndex = nextIndex;
-        history.totalStates++;
+    int status = editorRedo(buffer);
 
+    if (status == EDITOR_OK) {
         std::cout << "Redo completed." << std::endl;
     } else {
         std::cout << "Nothing to redo." << std::endl;
     }
 }
 
-extern "C" void freeHistory(void) {
-    for(int i = 0; i < 10; i++) {
-        if(history.states[i] != NULL) {
-            free(history.states[i]);
-            history.states[i] = NULL;
-        }
-        history.stateSizes[i] = 0;
-    }
-    history.currentIndex = -1;
-    history.totalStates = 0;
+extern "C" void freeHistory(TextBuffer* buffer) {
+    bufferDisableHistory(buffer);
 }
 
-int findPosition(TextBuffer* buffer, int line, int index) {
-    if (buffer->used == 0) return -1;
-
-    int currentLine = 0;
-    int pos = 0;
-
-    while (pos < buffer->used && currentLine < line) {
-        if (buffer->content[pos] == '\n') {
-            currentLine++;
-        }
-        pos++;
+extern "C" void printHistoryStats(TextBuffer* buffer) {
+    HistoryStats stats;
+    if (bufferHistoryStats(buffer, &stats) != 0) {
+        std::cout << "History is not available." << std::endl;
+        return;
     }
 
-    if (currentLine < line) return -1;
-
-    int lineStart = pos;
-    int lineLength = 0;
-    while ((lineStart + lineLength) < buffer->used && buffer->content[lineStart + lineLength] != '\n') {
-        lineLength++;
+    std::cout << "Undo entries: " << stats.undoEntries << ", redo entries: " << stats.redoEntries << std::endl;
+    std::cout << "Memory used: " << stats.storedBytes << " of " << stats.budget << " bytes" << std::endl;
+    std::cout << "Compressed entries: " << stats.compressedEntries << " (" << stats.compressedRawBytes
+              << " -> " << stats.compressedBytes << " bytes";
+    if (stats.compressedBytes > 0) {
+        std::cout << ", ratio " << (double)stats.compressedRawBytes / stats.compressedBytes << ":1";
     }
-
-    if (index > lineLength) return -1;
-
-    return pos + index;
+    std::cout << ")" << std::endl;
+    std::cout << "Evicted entries: " << stats.evictedEntries << std::endl;
 }
 
-
 extern "C" void deleteText(TextBuffer* buffer) {
-    saveState(buffer);
-
     int line, index, numberOfChar;
     std::cout << "Choose line, index and number of symbols: ";
     if (!(std::cin >> line >> index >> numberOfChar)) {
@@ -134,21 +75,22 @@ extern "C" void deleteText(TextBuffer* buffer) {
         return;
     }
 
-    int startPos = findPosition(buffer, line, index);
-    if (startPos == -1 || startPos >= buffer->used) {
+    size_t actualDelete = 0;
+    int status = editorDelete(buffer, (size_t)line, (size_t)index, (size_t)numberOfChar, &actualDelete);
+    if (status == EDITOR_ERROR_POSITION) {
         std::cout << "Error: Invalid line or index." << std::endl;
         return;
     }
-
-    int actualDelete = MIN(numberOfChar, buffer->used - startPos);
-    memmove(buffer->content + startPos, buffer->content + startPos + actualDelete, buffer->used - startPos - actualDelete + 1);
-    buffer->used -= actualDelete;
+    if (status != EDITOR_OK) {
+        std::cout << "Error: Failed to delete text." << std::endl;
+        return;
+    }
 
     std::cout << "Deleted " << actualDelete << " character(s)." << std::endl;
-    saveState(buffer);
 }
 
-extern "C" void copyText(TextBuffer* buffer) {
+// Ask for a range and copy or cut it into the named register (0 = default)
+static bool promptCopy(TextBuffer* buffer, char name, bool cut, size_t& copied) {
     int line, index, numberOfChar;
 
     std::cout << "Choose line, index and number of symbols: ";
@@ -156,135 +98,146 @@ extern "C" void copyText(TextBuffer* buffer) {
         std::cout << "Invalid input format." << std::endl;
         std::cin.clear();
         std::cin.ignore(1000, '\n');
-        return;
+        return false;
     }
 
     if (line < 0 || index < 0 || numberOfChar < 0) {
         std::cout << "Error: All values must be non-negative." << std::endl;
-        return;
+        return false;
     }
 
-    int startPos = findPosition(buffer, line, index);
-    if (startPos == -1) {
+    int status = cut ? editorCut(buffer, (size_t)line, (size_t)index, (size_t)numberOfChar, name, &copied)
+                     : editorCopy(buffer, (size_t)line, (size_t)index, (size_t)numberOfChar, name, &copied);
+    if (status == EDITOR_ERROR_POSITION) {
         std::cout << "Error: Invalid line or index." << std::endl;
-        return;
+        return false;
     }
-
-    int maxCopy = buffer->used - startPos;
-    int actualCopy = (numberOfChar > maxCopy) ? maxCopy : numberOfChar;
-
-    if (actualCopy > 0 && actualCopy < 1024) {
-        strncpy(clipboard, buffer->content + startPos, actualCopy);
-        clipboard[actualCopy] = '\0';
-        std::cout << "Copied " << actualCopy << " character(s) to clipboard." << std::endl;
-    } else {
-        std::cout << "Nothing to copy or text too long for clipboard." << std::endl;
+    if (status != EDITOR_OK) {
+        std::cout << (cut ? "Nothing to cut." : "Nothing to copy.") << std::endl;
+        return false;
     }
+    return true;
 }
 
-extern "C" void cutText(TextBuffer* buffer) {
-    saveState(buffer);
+// Ask for a position and paste the named register there
+static void promptPaste(TextBuffer* buffer, char name) {
+    if (clipboardRegisterInfo(name, nullptr, nullptr, nullptr, 0) != 0) {
+        std::cout << "Clipboard is empty." << std::endl;
+        return;
+    }
 
-    int line, index, numberOfChar;
+    int line, index;
 
-    std::cout << "Choose line, index and number of symbols: ";
-    if (!(std::cin >> line >> index >> numberOfChar)) {
+    std::cout << "Choose line and index: ";
+    if (!(std::cin >> line >> index)) {
         std::cout << "Invalid input format." << std::endl;
         std::cin.clear();
         std::cin.ignore(1000, '\n');
         return;
     }
 
-    if (line < 0 || index < 0 || numberOfChar < 0) {
-        std::cout << "Error: All values must be non-negative." << std::endl;
+    if (line < 0 || index < 0) {
+        std::cout << "Error: Line and index must be non-negative." << std::endl;
         return;
     }
 
-    int startPos = findPosition(buffer, line, index);
-    if (startPos == -1) {
+    size_t pasted = 0;
+    int status = editorPaste(buffer, (size_t)line, (size_t)index, name, &pasted);
+    if (status == EDITOR_ERROR_POSITION) {
         std::cout << "Error: Invalid line or index." << std::endl;
         return;
     }
-
-    int maxCut = buffer->used - startPos;
-    int actualCut = (numberOfChar > maxCut) ? maxCut : numberOfChar;
-
-    if (actualCut > 0 && actualCut < 1024) {
-        strncpy(clipboard, buffer->content + startPos, actualCut);
-        clipboard[actualCut] = '\0';
-
-        memmove(buffer->content + startPos,
-                buffer->content + startPos + actualCut,
-                buffer->used - startPos - actualCut + 1);
-
-        buffer->used -= actualCut;
-        std::cout << "Cut " << actualCut << " character(s) to clipboard." << std::endl;
-
-        saveState(buffer);
-    } else {
-        std::cout << "Nothing to cut or text too long for clipboard." << std::endl;
-    }
-}
-
-extern "C" void pasteText(TextBuffer* buffer) {
-    if (strlen(clipboard) == 0) {
-        std::cout << "Clipboard is empty." << std::endl;
+    if (status != EDITOR_OK) {
+        std::cout << "Error: Failed to paste text." << std::endl;
         return;
     }
 
-    saveState(buffer);
-
-    int line, index;
+    std::cout << "Pasted " << pasted << " character(s) from clipboard." << std::endl;
+}
 
-    std::cout << "Choose line and index: ";
-    if (!(std::cin >> line >> index)) {
+static bool readRegisterName(const char* prompt, bool allowRing, char& name) {
+    std::cout << prompt;
+    if (!(std::cin >> name)) {
         std::cout << "Invalid input format." << std::endl;
         std::cin.clear();
         std::cin.ignore(1000, '\n');
-        return;
+        return false;
     }
 
-    if (line < 0 || index < 0) {
-        std::cout << "Error: Line and index must be non-negative." << std::endl;
-        return;
+    if (clipboardIsRegister(name, !allowRing)) {
+        return true;
     }
+    std::cout << "Error: Unknown register." << std::endl;
+    return false;
+}
 
-    int pastePos = findPosition(buffer, line, index);
-    if (pastePos == -1) {
-        std::cout << "Error: Invalid line or index." << std::endl;
-        return;
+extern "C" void copyText(TextBuffer* buffer) {
+    size_t copied;
+    if (promptCopy(buffer, 0, false, copied)) {
+        std::cout << "Copied " << copied << " character(s) to clipboard." << std::endl;
     }
+}
 
-    size_t clipboardLen = strlen(clipboard);
-
-    if (buffer->used + clipboardLen + 1 > buffer->size) {
-        size_t newSize = buffer->size + clipboardLen + 1024;
-        char* newBuffer = (char*)realloc(buffer->content, newSize);
-        if (newBuffer == NULL) {
-            std::cout << "Error: Memory allocation failed." << std::endl;
-            return;
-        }
-        buffer->content = newBuffer;
-        buffer->size = newSize;
+extern "C" void cutText(TextBuffer* buffer) {
+    size_t copied;
+    if (!promptCopy(buffer, 0, true, copied)) return;
+
+    std::cout << "Cut " << copied << " character(s) to clipboard." << std::endl;
+}
+
+extern "C" void pasteText(TextBuffer* buffer) {
+    promptPaste(buffer, 0);
+}
+
+extern "C" void copyToRegister(TextBuffer* buffer) {
+    char name;
+    if (!readRegisterName("Choose register (a-z): ", false, name)) return;
+
+    size_t copied;
+    if (promptCopy(buffer, name, false, copied)) {
+        std::cout << "Copied " << copied << " character(s) to register " << name << "." << std::endl;
     }
+}
+
+extern "C" void pasteFromRegister(TextBuffer* buffer) {
+    char name;
+    if (!readRegisterName("Choose register (a-z, or 0-9 for recent copies): ", true, name)) return;
 
-    memmove(buffer->content + pastePos + clipboardLen,
-            buffer->content + pastePos,
-            buffer->used - pastePos + 1);
+    promptPaste(buffer, name);
+}
 
-    memcpy(buffer->content + pastePos, clipboard, clipboardLen);
-    buffer->used += clipboardLen;
+static void printRegister(char name) {
+    char preview[41];
+    size_t length;
+    int isReference;
+    if (clipboardRegisterInfo(name, &length, &isReference, preview, sizeof(preview)) != 0) return;
 
-    buffer->content[buffer->used] = '\0';
+    for (char* c = preview; *c; c++) {
+        if (*c == '\n' || *c == '\t' || *c == '\r') *c = ' ';
+    }
+    std::cout << "  " << name << ": " << length << " character(s)" << (isReference ? ", shared with the text" : "")
+              << "  \"" << preview << (length >= sizeof(preview) ? "...\"" : "\"") << std::endl;
+}
 
-    std::cout << "Pasted " << clipboardLen << " character(s) from clipboard." << std::endl;
+extern "C" void showClipboard(TextBuffer* buffer) {
+    (void)buffer;
 
-    saveState(buffer);
+    if (clipboardRegisterInfo(0, nullptr, nullptr, nullptr, 0) != 0) {
+        std::cout << "Clipboard is empty." << std::endl;
+        return;
+    }
+
+    std::cout << "Recent copies:" << std::endl;
+    for (char name = '0'; name <= '9'; name++) {
+        printRegister(name);
+    }
+    std::cout << "Registers:" << std::endl;
+    for (char name = 'a'; name <= 'z'; name++) {
+        printRegister(name);
+    }
 }
 
 extern "C" void insertWithReplacement(TextBuffer* buffer) {
-    saveState(buffer);
-
     int line, index;
     char input[1024];
     std::cout << "Choose line and index: ";
@@ -300,18 +253,20 @@ extern "C" void insertWithReplacement(TextBuffer* buffer) {
         return;
     }
 
-    int insertPos = findPosition(buffer, line, index);
-    if (insertPos == -1 || insertPos >= buffer->used) {
+    if (line < 0 || index < 0) {
         std::cout << "Error: Invalid line or index." << std::endl;
         return;
     }
 
-    size_t inputLen = strlen(input);
-    int maxReplace = std::min((int)(buffer->size - insertPos - 1), (int)inputLen);
-    memcpy(buffer->content + insertPos, input, maxReplace);
-    buffer->used = MAX(buffer->used, insertPos + maxReplace);
-    buffer->content[buffer->used] = '\0';
+    int status = editorReplace(buffer, (size_t)line, (size_t)index, input, strlen(input));
+    if (status == EDITOR_ERROR_POSITION) {
+        std::cout << "Error: Invalid line or index." << std::endl;
+        return;
+    }
+    if (status != EDITOR_OK) {
+        std::cout << "Error: Failed to insert text." << std::endl;
+        return;
+    }
 
     std::cout << "Text inserted with replacement." << std::endl;
-    saveState(buffer);
 }
\ No newline at end of file
@@ -3,14 +3,13 @@
 #include <string.h>
 #include "main.h"
 
-#define INITIAL_BUFFER_SIZE 1024
 #define MAX_FILENAME_LENGTH 100
 #define MAX_INPUT_LENGTH 1024
+#define JOURNAL_PATH ".notionSecondEdition.journal"
 
 void displayMenu(void);
 void processuserOption(int userOption, TextBuffer* buffer);
 void initializeBuffer(TextBuffer* buffer);
-void resizeBufferIfNeeded(TextBuffer* buffer, size_t additionalSpace);
 void freeBuffer(TextBuffer* buffer);
 void appendText(TextBuffer* buffer);
 void addNewLine(TextBuffer* buffer);
@@ -22,14 +21,67 @@ void searchText(TextBuffer* buffer);
 void clearConsole(void);
 void clearInputBuffer(void);
 void deleteText(TextBuffer* buffer);
-
-int main() {
+void searchMultipleTexts(TextBuffer* buffer);
+void searchRegex(TextBuffer* buffer);
+void searchTextParallel(TextBuffer* buffer);
+int ingestInput(TextBuffer* buffer, const char* outputPath);
+int encryptManifest(const char* manifestPath, size_t ioThreads);
+void openJournal(TextBuffer* buffer);
+void reportJournalFailure(TextBuffer* buffer);
+
+int main(int argc, char* argv[]) {
     int userOption = -1;
     TextBuffer buffer;
 
+    if (argc >= 4 && strcmp(argv[1], "--bench-search") == 0) {
+        size_t maxThreads = argc >= 5 ? (size_t)strtoul(argv[4], NULL, 10) : 0;
+        return runSearchBenchmark(argv[2], argv[3], maxThreads) == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    if (argc >= 3 && strcmp(argv[1], "--bench-encrypt") == 0) {
+        size_t maxThreads = argc >= 4 ? (size_t)strtoul(argv[3], NULL, 10) : 0;
+        return runEncryptBenchmark(argv[2], maxThreads) == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    if (argc >= 3 && strcmp(argv[1], "--encrypt-batch") == 0) {
+        size_t ioThreads = argc >= 4 ? (size_t)strtoul(argv[3], NULL, 10) : 0;
+        return encryptManifest(argv[2], ioThreads) == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
     initializeBuffer(&buffer);
-    initHistory();
-    saveState(&buffer);
+
+    // With an output path, ingest is a one-shot conversion
+    if (argc >= 3 && strcmp(argv[1], "--ingest") == 0) {
+        int status = ingestInput(&buffer, argv[2]);
+        freeBuffer(&buffer);
+        return status == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    // Batch mode runs a command script instead of the menu
+    if (argc >= 2 && strcmp(argv[1], "--batch") == 0) {
+        initHistory(&buffer);
+        int status = runBatchScript(&buffer, argc >= 3 ? argv[2] : NULL);
+        freeBuffer(&buffer);
+        return status == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    openJournal(&buffer);
+
+    if (argc >= 2 && strcmp(argv[1], "--ingest") == 0) {
+        if (ingestInput(&buffer, NULL) != 0) {
+            freeBuffer(&buffer);
+            return EXIT_FAILURE;
+        }
+
+        // stdin is used up by the stream; keep editing from the terminal
+        if (freopen("/dev/tty", "r", stdin) == NULL) {
+            fprintf(stderr, "No terminal available for interactive editing.\n");
+            freeBuffer(&buffer);
+            return EXIT_SUCCESS;
+        }
+    }
+
+    initHistory(&buffer);
 
     while (userOption != 0) {
         displayMenu();
@@ -47,6 +99,7 @@ int main() {
         }
 
         processuserOption(userOption, &buffer);
+        reportJournalFailure(&buffer);
     }
 
     freeBuffer(&buffer);
@@ -76,6 +129,13 @@ void displayMenu(void) {
     printf("19. Decrypt text file\n");
     printf("20. Save encrypted text\n");
     printf("21. Load encrypted text\n");
+    printf("22. Search for multiple texts\n");
+    printf("23. Search with regular expression\n");
+    printf("24. Search for text (parallel)\n");
+    printf("25. Show undo history statistics\n");
+    printf("26. Copy text to a register\n");
+    printf("27. Paste from a register\n");
+    printf("28. Show clipboard registers\n");
     printf("0. Exit\n");
     printf("Enter your choice: ");
 }
@@ -144,56 +204,48 @@ void processuserOption(int userOption, TextBuffer* buffer) {
             break;
         case 21:
             loadEncryptedText(buffer);
+            break;
+        case 22:
+            searchMultipleTexts(buffer);
+            break;
+        case 23:
+            searchRegex(buffer);
+            break;
+        case 24:
+            searchTextParallel(buffer);
+            break;
+        case 25:
+            printHistoryStats(buffer);
+            break;
+        case 26:
+            copyToRegister(buffer);
+            break;
+        case 27:
+            pasteFromRegister(buffer);
+            break;
+        case 28:
+            showClipboard(buffer);
+            break;
         default:
             printf("Error. U've sent smth strange. Try again\n");
     }
 }
 
 void initializeBuffer(TextBuffer* buffer) {
-    buffer->content = (char*)malloc(INITIAL_BUFFER_SIZE * sizeof(char));
-    if (buffer->content == NULL) {
-        fprintf(stderr, "Memory allocation failed. Exiting program.\n");
+    if (editorCreate(buffer) != EDITOR_OK) {
+        fprintf(stderr, "Buffer initialization failed. Exiting program.\n");
         exit(EXIT_FAILURE);
     }
-
-    buffer->size = INITIAL_BUFFER_SIZE;
-    buffer->used = 0;
-    buffer->content[0] = '\0';
-}
-
-void resizeBufferIfNeeded(TextBuffer* buffer, size_t additionalSpace) {
-    if (buffer->used + additionalSpace + 1 > buffer->size) {
-        size_t newSize = buffer->size * 2;
-        if (newSize < buffer->used + additionalSpace + 1) {
-            newSize = buffer->used + additionalSpace + 1 + INITIAL_BUFFER_SIZE;
-        }
-
-        char* newBuffer = (char*)realloc(buffer->content, newSize);
-        if (newBuffer == NULL) {
-            fprintf(stderr, "Memory reallocation failed. Cannot expand buffer.\n");
-            return;
-        }
-
-        buffer->content = newBuffer;
-        buffer->size = newSize;
-
-        printf("Buffer resized to %zu bytes\n", buffer->size);
-    }
 }
 
 void freeBuffer(TextBuffer* buffer) {
-    if (buffer->content != NULL) {
-        free(buffer->content);
-        buffer->content = NULL;
-        buffer->size = 0;
-        buffer->used = 0;
-    }
-    freeHistory();
+    // Also discards the crash journal: reaching here is a clean exit
+    editorDestroy(buffer);
 }
 
 void appendText(TextBuffer* buffer) {
-    saveState(buffer);
     char input[MAX_INPUT_LENGTH];
+    int lineEnded = 0;
 
     printf("Enter text to append: ");
     if (fgets(input, MAX_INPUT_LENGTH, stdin) == NULL) {
@@ -201,33 +253,41 @@ void appendText(TextBuffer* buffer) {
         return;
     }
 
-    size_t len = strlen(input);
-    if (len > 0 && input[len-1] == '\n') {
-        input[len-1] = '\0';
-        len--;
-    }
-
-    resizeBufferIfNeeded(buffer, len);
+    // Lines longer than the input buffer arrive in several pieces; the
+    // later ones continue the same undo step
+    int firstPiece = 1;
+    do {
+        size_t len = strlen(input);
+        if (len > 0 && input[len-1] == '\n') {
+            input[len-1] = '\0';
+            len--;
+            lineEnded = 1;
+        }
 
-    strcat(buffer->content, input);
-    buffer->used += len;
+        int status = firstPiece ? editorAppend(buffer, input, len) : bufferAppend(buffer, input, len);
+        if (status != EDITOR_OK) {
+            printf("Error: Failed to append text.\n");
+            return;
+        }
+        firstPiece = 0;
+    } while (!lineEnded && fgets(input, MAX_INPUT_LENGTH, stdin) != NULL);
 
     printf("Text appended successfully.\n");
 }
 
 void addNewLine(TextBuffer* buffer) {
-    saveState(buffer);
-    resizeBufferIfNeeded(buffer, 1);
-
-    strcat(buffer->content, "\n");
-    buffer->used += 1;
+    if (editorAppend(buffer, "\n", 1) != EDITOR_OK) {
+        printf("Error: Failed to start a new line.\n");
+        return;
+    }
 
     printf("New line started.\n");
 }
 
 void saveToFile(TextBuffer* buffer) {
     char filename[MAX_FILENAME_LENGTH];
-    FILE* file;
+    size_t bytesWritten = 0;
+    double seconds = 0;
 
     printf("Enter the file name for saving: ");
     if (fgets(filename, MAX_FILENAME_LENGTH, stdin) == NULL) {
@@ -240,26 +300,100 @@ void saveToFile(TextBuffer* buffer) {
         filename[len-1] = '\0';
     }
 
-    file = fopen(filename, "w");
-    if (file == NULL) {
-        printf("Error: Could not open file %s for writing.\n", filename);
+    if (editorSave(buffer, filename, &bytesWritten, &seconds) != EDITOR_OK) {
+        printf("Error: Failed to write to file %s.\n", filename);
         return;
     }
 
-    if (fputs(buffer->content, file) == EOF) {
-        printf("Error: Failed to write to file %s.\n", filename);
-        fclose(file);
+    printf("Text has been saved successfully to %s.\n", filename);
+    if (seconds > 0) {
+        printf("Wrote %zu bytes in %.3f s (%.1f MB/s).\n", bytesWritten, seconds,
+               bytesWritten / (1024.0 * 1024.0) / seconds);
+    }
+}
+
+void openJournal(TextBuffer* buffer) {
+    size_t replayedEdits = 0;
+    int status = bufferOpenJournal(buffer, JOURNAL_PATH, &replayedEdits);
+
+    const char* reason = editorLastError();
+    if (status < 0) {
+        if (reason[0] != '\0') {
+            fprintf(stderr, "%s\n", reason);
+        }
+        fprintf(stderr, "Warning: edit journal unavailable; unsaved edits will not survive a crash.\n");
         return;
     }
+    if (reason[0] != '\0') {
+        fprintf(stderr, "%s\n", reason);
+    }
+    if (status > 0) {
+        printf("Recovered the previous unsaved session (%zu edits replayed, %zu characters).\n",
+               replayedEdits, buffer->used);
+    }
+}
 
-    fclose(file);
-    printf("Text has been saved successfully to %s.\n", filename);
+// The journal is written in the background; say so once if it stops working
+void reportJournalFailure(TextBuffer* buffer) {
+    static int reported = 0;
+    char message[256];
+
+    if (!reported && bufferJournalFailed(buffer, message, sizeof(message))) {
+        fprintf(stderr, "%s\n", message);
+        reported = 1;
+    }
+}
+
+int ingestInput(TextBuffer* buffer, const char* outputPath) {
+    size_t bytesRead = 0;
+    double seconds = 0;
+
+    if (bufferIngest(buffer, fileno(stdin), &bytesRead, &seconds) != 0) {
+        fprintf(stderr, "Error: Failed to read standard input.\n");
+        return -1;
+    }
+
+    fprintf(stderr, "Ingested %zu bytes in %.3f s", bytesRead, seconds);
+    if (seconds > 0) {
+        fprintf(stderr, " (%.1f MB/s)", bytesRead / (1024.0 * 1024.0) / seconds);
+    }
+    fprintf(stderr, ", %zu lines.\n", bufferLineCount(buffer));
+
+    if (outputPath != NULL && bufferSaveFile(buffer, outputPath, NULL, NULL) != 0) {
+        fprintf(stderr, "Error: Failed to write to file %s.\n", outputPath);
+        return -1;
+    }
+    return 0;
+}
+
+int encryptManifest(const char* manifestPath, size_t ioThreads) {
+    EncryptBatchStats stats;
+    int status = editorEncryptManifest(manifestPath, ioThreads, &stats);
+
+    if (status == EDITOR_ERROR_CIPHER) {
+        fprintf(stderr, "Error: Caesar cipher is not ready. %s\n", editorLastError());
+        return -1;
+    }
+    if (status != EDITOR_OK) {
+        fprintf(stderr, "Error: Could not read manifest %s.\n", manifestPath);
+        return -1;
+    }
+
+    // One line per job that failed or was skipped
+    fputs(editorLastError(), stderr);
+
+    double megabytes = stats.bytes / (1024.0 * 1024.0);
+    fprintf(stderr, "Encrypted %zu file(s), %zu failed, %.1f MB in %.3f s", stats.files, stats.failed,
+            megabytes, stats.seconds);
+    if (stats.seconds > 0) {
+        fprintf(stderr, " (%.0f files/s, %.1f MB/s)", stats.files / stats.seconds, megabytes / stats.seconds);
+    }
+    fprintf(stderr, ".\n");
+    return stats.failed == 0 ? 0 : -1;
 }
 
 void loadFromFile(TextBuffer* buffer) {
-    saveState(buffer);
     char filename[MAX_FILENAME_LENGTH];
-    FILE* file;
 
     printf("Enter the file name for loading: ");
     if (fgets(filename, MAX_FILENAME_LENGTH, stdin) == NULL) {
@@ -272,34 +406,11 @@ void loadFromFile(TextBuffer* buffer) {
         filename[len-1] = '\0';
     }
 
-    file = fopen(filename, "r");
-    if (file == NULL) {
+    if (editorLoad(buffer, filename) != EDITOR_OK) {
         printf("Error: Could not open file %s for reading.\n", filename);
         return;
     }
 
-    buffer->content[0] = '\0';
-    buffer->used = 0;
-
-    int c;
-    size_t index = 0;
-
-    while ((c = fgetc(file)) != EOF) {
-        if (index + 1 >= buffer->size) {
-            resizeBufferIfNeeded(buffer, INITIAL_BUFFER_SIZE);
-            if (index + 1 >= buffer->size) {
-                printf("Error: Buffer couldn't be resized enough to load file.\n");
-                break;
-            }
-        }
-
-        buffer->content[index++] = (char)c;
-    }
-
-    buffer->content[index] = '\0';
-    buffer->used = index;
-
-    fclose(file);
     printf("Text has been loaded successfully from %s.\n", filename);
 }
 
@@ -309,6 +420,7 @@ void printCurrentText(TextBuffer* buffer) {
         return;
     }
 
+    flattenBuffer(buffer);
     printf("\n! Current Text Content !\n");
     printf("%s\n", buffer->content);
     printf("! End of Content !\n");
@@ -316,20 +428,18 @@ void printCurrentText(TextBuffer* buffer) {
 }
 
 void insertTextAtPosition(TextBuffer* buffer) {
-    saveState(buffer);
     int line, position;
     char input[MAX_INPUT_LENGTH];
 
     printf("\nCurrent text with line numbers:\n");
-
-    int lineCount = 0;
-    int lineStart = 0;
-    for (size_t i = 0; i <= buffer->used; i++) {
-        if (buffer->content[i] == '\n' || buffer->content[i] == '\0') {
-            printf("%d: %.*s\n", lineCount, (int)(i - lineStart), buffer->content + lineStart);
-            lineStart = i + 1;
-            lineCount++;
-        }
+    flattenBuffer(buffer);
+
+    int lineCount = (int)bufferLineCount(buffer);
+    for (int i = 0; i < lineCount; i++) {
+        size_t lineStart = 0, lineLength = 0;
+        bufferLineToOffset(buffer, (size_t)i, 0, &lineStart);
+        bufferLineLength(buffer, (size_t)i, &lineLength);
+        printf("%d: %.*s\n", i, (int)lineLength, buffer->content + lineStart);
     }
 
     printf("Choose line and index: ");
@@ -345,29 +455,14 @@ void insertTextAtPosition(TextBuffer* buffer) {
         return;
     }
 
-    int actualPos = 0;
-    int currentLine = 0;
-
-    while (currentLine < line && buffer->content[actualPos] != '\0') {
-        if (buffer->content[actualPos] == '\n') {
-            currentLine++;
-        }
-        actualPos++;
-    }
+    size_t lineLength = 0;
+    bufferLineLength(buffer, (size_t)line, &lineLength);
 
-    int lineLength = 0;
-    while (buffer->content[actualPos + lineLength] != '\n' &&
-           buffer->content[actualPos + lineLength] != '\0') {
-        lineLength++;
-    }
-
-    if (position < 0 || position > lineLength) {
-        printf("Error: Invalid position. Must be between 0 and %d for this line.\n", lineLength);
+    if (position < 0 || (size_t)position > lineLength) {
+        printf("Error: Invalid position. Must be between 0 and %zu for this line.\n", lineLength);
         return;
     }
 
-    actualPos += position;
-
     printf("Enter text to insert: ");
     if (fgets(input, MAX_INPUT_LENGTH, stdin) == NULL) {
         printf("Error reading input.\n");
@@ -380,14 +475,10 @@ void insertTextAtPosition(TextBuffer* buffer) {
         len--;
     }
 
-    resizeBufferIfNeeded(buffer, len);
-
-    memmove(buffer->content + actualPos + len,
-            buffer->content + actualPos,
-            buffer->used - actualPos + 1);
-
-    memcpy(buffer->content + actualPos, input, len);
-    buffer->used += len;
+    if (editorInsert(buffer, (size_t)line, (size_t)position, input, len) != EDITOR_OK) {
+        printf("Error: Failed to insert text.\n");
+        return;
+    }
 
     printf("Text inserted successfully.\n");
 }
@@ -412,37 +503,180 @@ void searchText(TextBuffer* buffer) {
         return;
     }
 
-    char* pos = buffer->content;
-    int found = 0;
-    int line = 0;
-    int linePos = 0;
+    SearchResults results;
+    if (editorSearch(buffer, searchStr, len, &results) != EDITOR_OK) {
+        printf("Error: Search failed.\n");
+        return;
+    }
 
     printf("\nSearch results for '%s':\n", searchStr);
 
-    while ((pos = strstr(pos, searchStr)) != NULL) {
-        line = 0;
-        linePos = 0;
+    for (size_t i = 0; i < results.count; i++) {
+        printf("Text is present in this position: %zu %zu\n", results.matches[i].line, results.matches[i].column);
+    }
+
+    size_t found = results.count;
+    freeSearchResults(&results);
+
+    if (found == 0) {
+        printf("No matches found for '%s'.\n", searchStr);
+    } else {
+        printf("Found %zu occurrence(s).\n", found);
+    }
+}
+
+void searchMultipleTexts(TextBuffer* buffer) {
+    char** patterns = NULL;
+    size_t* lengths = NULL;
+    size_t patternCount = 0;
+    char input[MAX_INPUT_LENGTH];
+
+    printf("Enter texts to search, one per line (empty line to finish):\n");
+    while (fgets(input, MAX_INPUT_LENGTH, stdin) != NULL) {
+        size_t len = strlen(input);
+        if (len > 0 && input[len-1] == '\n') {
+            input[len-1] = '\0';
+            len--;
+        }
+        if (len == 0) break;
+
+        char** newPatterns = (char**)realloc(patterns, (patternCount + 1) * sizeof(char*));
+        size_t* newLengths = (size_t*)realloc(lengths, (patternCount + 1) * sizeof(size_t));
+        if (newPatterns != NULL) patterns = newPatterns;
+        if (newLengths != NULL) lengths = newLengths;
+        if (newPatterns == NULL || newLengths == NULL) {
+            printf("Error: Memory allocation failed.\n");
+            break;
+        }
+
+        patterns[patternCount] = (char*)malloc(len + 1);
+        if (patterns[patternCount] == NULL) {
+            printf("Error: Memory allocation failed.\n");
+            break;
+        }
+        memcpy(patterns[patternCount], input, len + 1);
+        lengths[patternCount] = len;
+        patternCount++;
+    }
+
+    if (patternCount == 0) {
+        printf("No search texts given.\n");
+    } else {
+        SearchResults results;
+        if (searchBufferMulti(buffer, (const char* const*)patterns, lengths, patternCount, &results) != 0) {
+            printf("Error: Search failed.\n");
+        } else {
+            printf("\nSearch results for %zu text(s):\n", patternCount);
+            for (size_t i = 0; i < results.count; i++) {
+                printf("'%s' is present in this position: %zu %zu\n",
+                       patterns[results.matches[i].patternId],
+                       results.matches[i].line, results.matches[i].column);
+            }
 
-        for (char* p = buffer->content; p < pos; p++) {
-            if (*p == '\n') {
-                line++;
-                linePos = 0;
+            if (results.count == 0) {
+                printf("No matches found.\n");
             } else {
-                linePos++;
+                printf("Found %zu occurrence(s).\n", results.count);
             }
+            freeSearchResults(&results);
         }
+    }
+
+    for (size_t i = 0; i < patternCount; i++) {
+        free(patterns[i]);
+    }
+    free(patterns);
+    free(lengths);
+}
 
-        printf("Text is present in this position: %d %d\n", line, linePos);
-        found++;
+void searchRegex(TextBuffer* buffer) {
+    char pattern[MAX_INPUT_LENGTH];
 
-        pos += len;
+    printf("Enter regular expression: ");
+    if (fgets(pattern, MAX_INPUT_LENGTH, stdin) == NULL) {
+        printf("Error reading input.\n");
+        return;
     }
 
-    if (found == 0) {
+    size_t len = strlen(pattern);
+    if (len > 0 && pattern[len-1] == '\n') {
+        pattern[len-1] = '\0';
+        len--;
+    }
+
+    if (len == 0) {
+        printf("Regular expression cannot be empty.\n");
+        return;
+    }
+
+    SearchResults results;
+    if (editorSearchRegex(buffer, pattern, len, &results) != EDITOR_OK) {
+        printf("%s\n", editorLastError());
+        return;
+    }
+
+    printf("\nSearch results for /%s/:\n", pattern);
+    flattenBuffer(buffer);
+    for (size_t i = 0; i < results.count; i++) {
+        printf("'%.*s' is present in this position: %zu %zu\n",
+               (int)results.matches[i].length, buffer->content + results.matches[i].offset,
+               results.matches[i].line, results.matches[i].column);
+    }
+
+    if (results.count == 0) {
+        printf("No matches found for /%s/.\n", pattern);
+    } else {
+        printf("Found %zu occurrence(s).\n", results.count);
+    }
+    freeSearchResults(&results);
+}
+
+void searchTextParallel(TextBuffer* buffer) {
+    char searchStr[MAX_INPUT_LENGTH];
+    int threads;
+
+    printf("Enter text to search: ");
+    if (fgets(searchStr, MAX_INPUT_LENGTH, stdin) == NULL) {
+        printf("Error reading input.\n");
+        return;
+    }
+
+    size_t len = strlen(searchStr);
+    if (len > 0 && searchStr[len-1] == '\n') {
+        searchStr[len-1] = '\0';
+        len--;
+    }
+
+    if (len == 0) {
+        printf("Search string cannot be empty.\n");
+        return;
+    }
+
+    printf("Enter number of threads (0 = all cores): ");
+    if (scanf("%d", &threads) != 1 || threads < 0) {
+        printf("Invalid thread count.\n");
+        clearInputBuffer();
+        return;
+    }
+    clearInputBuffer();
+
+    SearchResults results;
+    if (searchBufferParallel(buffer, searchStr, len, (size_t)threads, &results) != 0) {
+        printf("Error: Search failed.\n");
+        return;
+    }
+
+    printf("\nSearch results for '%s':\n", searchStr);
+    for (size_t i = 0; i < results.count; i++) {
+        printf("Text is present in this position: %zu %zu\n", results.matches[i].line, results.matches[i].column);
+    }
+
+    if (results.count == 0) {
         printf("No matches found for '%s'.\n", searchStr);
     } else {
-        printf("Found %d occurrence(s).\n", found);
+        printf("Found %zu occurrence(s).\n", results.count);
     }
+    freeSearchResults(&results);
 }
 
 void clearConsole(void) {
@@ -2,68 +2,18 @@
 #define MAIN_H
 
 #include <stddef.h>
+#include "cpp/TextEditorApi.h"
+
+// Interactive editor: menu actions and command-line modes
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-// Basic text buffer structure
-typedef struct {
-    char* content;
-    size_t size;
-    size_t used;
-} TextBuffer;
-
-// Undo/Redo history structure
-typedef struct {
-    char* states[10];
-    size_t stateSizes[10];
-    int currentIndex;
-    int totalStates;
-} UndoRedoHistory;
-
-// Data types for lines
-typedef enum {
-    DATA_TYPE_TEXT = 0,
-    DATA_TYPE_CONTACT = 1,
-    DATA_TYPE_CHECKLIST = 2
-} DataType;
-
-// Contact information structure
-typedef struct {
-    char name[100];
-    char surname[100];
-    char email[150];
-} ContactInfo;
-
-// Checklist item structure
-typedef struct {
-    char info[200];
-    int checked; // 0 = unchecked, 1 = checked
-} ChecklistItem;
-
-// Line data structure
-typedef struct {
-    DataType type;
-    union {
-        char* text;
-        ContactInfo contact;
-        ChecklistItem checklist;
-    } data;
-} LineData;
-
-// Document structure
-typedef struct {
-    LineData* lines;
-    size_t lineCount;
-    size_t capacity;
-} Document;
-
 // Core operations
 void displayMenu(void);
 void processUserOption(int userOption, TextBuffer* buffer);
 void initializeBuffer(TextBuffer* buffer);
-void resizeBufferIfNeeded(TextBuffer* buffer, size_t additionalSpace);
 void freeBuffer(TextBuffer* buffer);
 void clearConsole(void);
 void clearInputBuffer(void);
@@ -77,17 +27,28 @@ void printCurrentText(TextBuffer* buffer);
 void insertTextAtPosition(TextBuffer* buffer);
 void searchText(TextBuffer* buffer);
 void deleteText(TextBuffer* buffer);
+void searchMultipleTexts(TextBuffer* buffer);
+void searchRegex(TextBuffer* buffer);
+void searchTextParallel(TextBuffer* buffer);
+int ingestInput(TextBuffer* buffer, const char* outputPath);
+int encryptManifest(const char* manifestPath, size_t ioThreads);
+void openJournal(TextBuffer* buffer);
+void reportJournalFailure(TextBuffer* buffer);
 
 // Undo/redo clipboard
-void initHistory(void);
+void initHistory(TextBuffer* buffer);
 void saveState(TextBuffer* buffer);
 void undoCommand(TextBuffer* buffer);
 void redoCommand(TextBuffer* buffer);
 void pasteText(TextBuffer* buffer);
 void copyText(TextBuffer* buffer);
 void cutText(TextBuffer* buffer);
+void copyToRegister(TextBuffer* buffer);
+void pasteFromRegister(TextBuffer* buffer);
+void showClipboard(TextBuffer* buffer);
 void insertWithReplacement(TextBuffer* buffer);
-void freeHistory(void);
+void freeHistory(TextBuffer* buffer);
+void printHistoryStats(TextBuffer* buffer);
 
 // Encryption
 void encryptCurrentText(TextBuffer* buffer);
@@ -97,6 +58,13 @@ void decryptTextFile(void);
 void saveEncryptedText(TextBuffer* buffer);
 void loadEncryptedText(TextBuffer* buffer);
 
+// Benchmarks
+int runSearchBenchmark(const char* path, const char* pattern, size_t maxThreads);
+int runEncryptBenchmark(const char* path, size_t maxThreads);
+
+// Batch mode: run a command script (stdin when path is NULL or "-")
+int runBatchScript(TextBuffer* buffer, const char* path);
+
 #ifdef __cplusplus
 }
 #endif